@@ -0,0 +1,228 @@
+// Offscreen benchmark for UI::Draw. Renders scripted board states into a
+// render texture on a hidden window and reports CPU time and draw calls per
+// frame. Runs on Mesa llvmpipe by default so results are comparable on
+// machines without a GPU; pass --gpu to use the system driver.
+//
+//   RenderBench [--frames N] [--gpu]
+
+#include "Board.h"
+#include "Input.h"
+#include "StatManager.h"
+#include "UI.h"
+#include "raylib.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// GL entry points raylib loaded through glad. Draw calls are counted by
+// swapping the two functions rlgl flushes its batches through for wrappers.
+extern "C" {
+typedef void (*DrawArraysProc)(unsigned int mode, int first, int count);
+typedef void (*DrawElementsProc)(unsigned int mode, int count,
+                                 unsigned int type, const void *indices);
+typedef void (*FinishProc)(void);
+typedef const unsigned char *(*GetStringProc)(unsigned int name);
+extern DrawArraysProc glad_glDrawArrays;
+extern DrawElementsProc glad_glDrawElements;
+extern FinishProc glad_glFinish;
+extern GetStringProc glad_glGetString;
+}
+
+static const unsigned int glRenderer = 0x1F01;
+
+static long drawCalls = 0;
+static DrawArraysProc realDrawArrays = nullptr;
+static DrawElementsProc realDrawElements = nullptr;
+
+static void CountDrawArrays(unsigned int mode, int first, int count) {
+  drawCalls++;
+  realDrawArrays(mode, first, count);
+}
+
+static void CountDrawElements(unsigned int mode, int count, unsigned int type,
+                              const void *indices) {
+  drawCalls++;
+  realDrawElements(mode, count, type, indices);
+}
+
+enum BoardState { STATE_FRESH, STATE_MID, STATE_REVEALED, STATE_FLAGGED };
+static const char *stateNames[] = {"fresh", "mid", "revealed", "flagged"};
+
+// Holds the mouse over the board centre; the first frame scrolls the wheel
+// far enough to reach the minimum zoom when `zoomOut` is set.
+class BenchInput : public InputSource {
+public:
+  BenchInput(Vector2 mouse, bool zoomOut) : mouse(mouse), zoomOut(zoomOut) {}
+
+protected:
+  bool Poll(FrameInput &next) override {
+    next.frameTime = 1.0f / 60.0f;
+    next.time = ++frame * (double)next.frameTime;
+    next.mouse = mouse;
+    next.wheel = zoomOut && frame == 1 ? -100.0f : 0.0f;
+    return true;
+  }
+
+private:
+  Vector2 mouse;
+  bool zoomOut;
+  int frame = 0;
+};
+
+// Plays a board into `state` with a fixed seed. Mid-game solves the top
+// half; fully revealed wins the game; flagged marks every mine.
+static void ScriptBoard(Board &board, BoardState state) {
+  board.SetSeed(12345);
+  if (state == STATE_FRESH)
+    return;
+  int w = board.GetWidth(), h = board.GetHeight();
+  board.Reveal(w / 2, h / 2);
+
+  int rows = state == STATE_MID ? h / 2 : h;
+  for (int y = 0; y < rows; y++) {
+    for (int x = 0; x < w; x++) {
+      const Cell &cell = board.GetCell(x, y);
+      if (cell.isMine) {
+        if (state != STATE_REVEALED)
+          board.ToggleFlag(x, y);
+      } else if (state != STATE_FLAGGED && !cell.isRevealed) {
+        board.Reveal(x, y);
+      }
+    }
+  }
+}
+
+struct Result {
+  double coldMs;  // First frame, building the atlas and caches
+  double cpuMs;   // Mean time to build and submit a frame
+  double p99Ms;
+  double totalMs; // Mean time including glFinish
+  double draws;   // Mean draw calls per frame
+};
+
+static Result RunCase(RenderTexture2D target, int width, int height,
+                      BoardState state, bool shader, bool zoomOut,
+                      int frames) {
+  using Clock = std::chrono::steady_clock;
+  auto ms = [](Clock::time_point a, Clock::time_point b) {
+    return std::chrono::duration<double, std::milli>(b - a).count();
+  };
+
+  Board board(width, height, std::max(1, width * height * 99 / 480));
+  ScriptBoard(board, state);
+  StatManager stats("");
+  // Centre of the board area below the 95px title bar and status header.
+  Vector2 mouse = {GetScreenWidth() / 2.0f,
+                   (GetScreenHeight() + 95) / 2.0f};
+  BenchInput input(mouse, zoomOut);
+  UI ui(board, stats, input);
+  ui.SetGridShader(shader);
+
+  Result result = {};
+  std::vector<double> cpu;
+  cpu.reserve(frames);
+  long totalDraws = 0;
+  for (int i = 0; i <= frames; i++) {
+    input.BeginFrame();
+    ui.UpdateCamera(false);
+
+    drawCalls = 0;
+    Clock::time_point t0 = Clock::now();
+    ui.Prepare();
+    BeginTextureMode(target);
+    ClearBackground(Color{28, 32, 38, 255});
+    ui.Draw(0.0f, 0, false);
+    EndTextureMode();
+    Clock::time_point t1 = Clock::now();
+    glad_glFinish();
+    Clock::time_point t2 = Clock::now();
+
+    if (i == 0) {
+      result.coldMs = ms(t0, t2);
+      continue;
+    }
+    cpu.push_back(ms(t0, t1));
+    result.totalMs += ms(t0, t2);
+    totalDraws += drawCalls;
+  }
+
+  double sum = 0.0;
+  for (double v : cpu)
+    sum += v;
+  std::sort(cpu.begin(), cpu.end());
+  result.cpuMs = sum / frames;
+  result.p99Ms = cpu[cpu.size() * 99 / 100];
+  result.totalMs /= frames;
+  result.draws = (double)totalDraws / frames;
+  return result;
+}
+
+int main(int argc, char **argv) {
+  int frames = 120;
+  bool gpu = false;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+      frames = std::max(1, std::atoi(argv[++i]));
+    } else if (std::strcmp(argv[i], "--gpu") == 0) {
+      gpu = true;
+    }
+  }
+
+  // Mesa reads this when the context is created.
+  if (!gpu) {
+#if defined(_WIN32)
+    _putenv_s("LIBGL_ALWAYS_SOFTWARE", "1");
+#else
+    setenv("LIBGL_ALWAYS_SOFTWARE", "1", 1);
+#endif
+  }
+
+  // The window and target match the game's expert-size window.
+  const int screenWidth = 30 * 32 + 40;
+  const int screenHeight = 16 * 32 + 135;
+  SetTraceLogLevel(LOG_WARNING);
+  SetConfigFlags(FLAG_WINDOW_UNDECORATED | FLAG_WINDOW_HIDDEN);
+  InitWindow(screenWidth, screenHeight, "RenderBench");
+  if (!IsWindowReady()) {
+    std::fprintf(stderr, "RenderBench: could not create a GL context\n");
+    return 1;
+  }
+  RenderTexture2D target = LoadRenderTexture(screenWidth, screenHeight);
+
+  realDrawArrays = glad_glDrawArrays;
+  realDrawElements = glad_glDrawElements;
+  glad_glDrawArrays = CountDrawArrays;
+  glad_glDrawElements = CountDrawElements;
+
+  std::printf("renderer: %s\nframes per case: %d\n\n",
+              (const char *)glad_glGetString(glRenderer), frames);
+  std::printf("%-10s %-9s %-7s %-4s %9s %8s %8s %9s %8s\n", "size", "state",
+              "mode", "zoom", "cold ms", "cpu ms", "p99 ms", "total ms",
+              "draws");
+
+  const int sizes[][2] = {{30, 16}, {100, 100}, {256, 256}, {1000, 1000}};
+  for (const auto &size : sizes) {
+    for (int state = STATE_FRESH; state <= STATE_FLAGGED; state++) {
+      for (int shader = 0; shader <= 1; shader++) {
+        for (int zoomOut = 0; zoomOut <= 1; zoomOut++) {
+          Result r = RunCase(target, size[0], size[1], (BoardState)state,
+                             shader != 0, zoomOut != 0, frames);
+          std::printf("%4dx%-5d %-9s %-7s %-4s %9.3f %8.3f %8.3f %9.3f "
+                      "%8.1f\n",
+                      size[0], size[1], stateNames[state],
+                      shader ? "shader" : "default", zoomOut ? "min" : "1",
+                      r.coldMs, r.cpuMs, r.p99Ms, r.totalMs, r.draws);
+        }
+      }
+    }
+  }
+
+  glad_glDrawArrays = realDrawArrays;
+  glad_glDrawElements = realDrawElements;
+  UnloadRenderTexture(target);
+  CloseWindow();
+  return 0;
+}
@@ -0,0 +1,248 @@
+// Headless Board for external solvers: reads requests from stdin and writes
+// one reply line per request to stdout, so a bot in any language can play
+// against the game's own rules by running this as a child process.
+//
+//   MinesweeperBot
+//
+// Requests, one per line:
+//
+//   new <w> <h> <mines> [seed <n>] [noguess]
+//       -> game <w> <h> <mines> <seed>
+//   r <x> <y> f <x> <y> c <x> <y> ...
+//       -> playing|won|lost <n> <x> <y> <cell> ...
+//   quit
+//
+// A move line holds any number of reveals (r), flag toggles (f) and chords
+// (c), applied in order; moves after the game ends are ignored as in the
+// game. The reply lists only the n cells whose state changed, each as its
+// coordinates and '#' hidden, 'F' flagged, '*' mine or '0'-'8'. A bad
+// request gets "err <reason>" and changes nothing.
+
+#include "Board.h"
+#include "Replay.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct Move {
+  ReplayAction action;
+  int x;
+  int y;
+};
+
+class BotSession {
+public:
+  // Returns false on "quit".
+  bool Handle(const std::string &line, std::string &reply);
+
+private:
+  void NewGame(std::string &reply);
+  void Play(std::string &reply);
+
+  Board board{9, 9, 10};
+  bool hasGame = false;
+  bool noGuess = false;
+  std::vector<Move> moves;
+  std::vector<int> changes;
+  // Marks cells already listed in the current reply; a cell flagged and
+  // unflagged in one batch is logged twice but reported once.
+  std::vector<uint32_t> reported;
+  uint32_t batch = 0;
+  std::vector<std::string_view> words; // the request being handled
+};
+
+static bool ParseInt(std::string_view text, long long &value) {
+  const char *end = text.data() + text.size();
+  auto result = std::from_chars(text.data(), end, value);
+  return result.ec == std::errc() && result.ptr == end;
+}
+
+static void AppendInt(std::string &reply, long long value) {
+  char digits[24];
+  auto result = std::to_chars(digits, digits + sizeof(digits), value);
+  reply.append(digits, result.ptr);
+}
+
+static char CellChar(const Cell &cell) {
+  if (!cell.isRevealed)
+    return cell.isFlagged ? 'F' : '#';
+  return cell.isMine ? '*' : (char)('0' + cell.neighborMines);
+}
+
+bool BotSession::Handle(const std::string &line, std::string &reply) {
+  words.clear();
+  size_t pos = 0;
+  while (pos < line.size()) {
+    size_t start = line.find_first_not_of(" \t\r", pos);
+    if (start == std::string::npos)
+      break;
+    size_t end = line.find_first_of(" \t\r", start);
+    if (end == std::string::npos)
+      end = line.size();
+    words.emplace_back(line.data() + start, end - start);
+    pos = end;
+  }
+
+  reply.clear();
+  if (words.empty()) {
+    reply = "err empty request\n";
+  } else if (words[0] == "quit") {
+    return false;
+  } else if (words[0] == "new") {
+    NewGame(reply);
+  } else {
+    Play(reply);
+  }
+  return true;
+}
+
+void BotSession::NewGame(std::string &reply) {
+  long long w, h, mines;
+  if (words.size() < 4 || !ParseInt(words[1], w) || !ParseInt(words[2], h) ||
+      !ParseInt(words[3], mines)) {
+    reply = "err usage: new <w> <h> <mines> [seed <n>] [noguess]\n";
+    return;
+  }
+  // The first click keeps a 3x3 area clear of mines.
+  if (w < 4 || h < 4 || w > Board::maxSide || h > Board::maxSide ||
+      mines < 1 || mines > w * h - 9) {
+    reply = "err board must be 4-8192 a side with 1 to w*h-9 mines\n";
+    return;
+  }
+  long long seed = -1;
+  bool guessFree = false;
+  for (size_t i = 4; i < words.size(); i++) {
+    if (words[i] == "noguess") {
+      guessFree = true;
+    } else if (words[i] == "seed" && i + 1 < words.size() &&
+               ParseInt(words[i + 1], seed) && seed >= 0 &&
+               seed <= UINT32_MAX) {
+      i++;
+    } else {
+      reply = "err unknown option\n";
+      return;
+    }
+  }
+
+  if (w == board.GetWidth() && h == board.GetHeight() &&
+      mines == board.GetTotalMines()) {
+    board.Reset();
+  } else {
+    board.Resize((int)w, (int)h, (int)mines);
+  }
+  if (reported.size() != (size_t)(w * h)) {
+    reported.assign(w * h, 0);
+    batch = 0;
+  }
+  if (seed >= 0)
+    board.SetSeed((uint32_t)seed);
+  noGuess = guessFree;
+  hasGame = true;
+
+  reply = "game ";
+  AppendInt(reply, w);
+  reply += ' ';
+  AppendInt(reply, h);
+  reply += ' ';
+  AppendInt(reply, mines);
+  reply += ' ';
+  AppendInt(reply, board.GetSeed());
+  reply += '\n';
+}
+
+void BotSession::Play(std::string &reply) {
+  if (!hasGame) {
+    reply = "err no game\n";
+    return;
+  }
+  // The whole line is checked before any move is applied.
+  moves.clear();
+  for (size_t i = 0; i < words.size(); i += 3) {
+    Move move;
+    if (words[i] == "r") {
+      move.action = ReplayAction::REVEAL;
+    } else if (words[i] == "f") {
+      move.action = ReplayAction::FLAG;
+    } else if (words[i] == "c") {
+      move.action = ReplayAction::CHORD;
+    } else {
+      reply = "err unknown request\n";
+      return;
+    }
+    long long x, y;
+    if (i + 2 >= words.size() || !ParseInt(words[i + 1], x) ||
+        !ParseInt(words[i + 2], y)) {
+      reply = "err usage: r|f|c <x> <y> ...\n";
+      return;
+    }
+    if (x < 0 || y < 0 || x >= board.GetWidth() || y >= board.GetHeight()) {
+      reply = "err cell out of range\n";
+      return;
+    }
+    move.x = (int)x;
+    move.y = (int)y;
+    moves.push_back(move);
+  }
+
+  changes.clear();
+  board.SetChangeLog(&changes);
+  for (const Move &move : moves)
+    ApplyReplayAction(board, move.action, move.x, move.y, noGuess);
+  board.SetChangeLog(nullptr);
+
+  // Stamps restart from zero only when the counter wraps.
+  if (++batch == 0) {
+    std::fill(reported.begin(), reported.end(), 0);
+    batch = 1;
+  }
+  size_t count = 0;
+  for (int index : changes) {
+    if (reported[index] != batch) {
+      reported[index] = batch;
+      changes[count++] = index;
+    }
+  }
+
+  reply = board.IsGameWon()    ? "won "
+          : board.IsGameOver() ? "lost "
+                               : "playing ";
+  AppendInt(reply, count);
+  int width = board.GetWidth();
+  for (size_t i = 0; i < count; i++) {
+    int x = changes[i] % width;
+    int y = changes[i] / width;
+    reply += ' ';
+    AppendInt(reply, x);
+    reply += ' ';
+    AppendInt(reply, y);
+    reply += ' ';
+    reply += CellChar(board.GetCell(x, y));
+  }
+  reply += '\n';
+}
+
+int main() {
+  // Bots exchange many small messages; keep C++ streams off stdio's locks.
+  std::ios::sync_with_stdio(false);
+  std::cin.tie(nullptr);
+
+  BotSession session;
+  std::string line, reply;
+  line.reserve(4096);
+  reply.reserve(4096);
+  while (std::getline(std::cin, line)) {
+    if (!session.Handle(line, reply))
+      break;
+    std::cout << reply;
+    // Replies go out once no further request is already buffered, so a bot
+    // that pipelines requests gets their replies in one write.
+    if (std::cin.rdbuf()->in_avail() == 0)
+      std::cout.flush();
+  }
+  std::cout.flush();
+  return 0;
+}
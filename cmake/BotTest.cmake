@@ -0,0 +1,32 @@
+# Feeds request lines to MinesweeperBot and checks that it exits cleanly with
+# one reply per request, each matching the expected pattern.
+#
+#   cmake -DBOT=MinesweeperBot "-DREQUESTS=new 9 9 10;r 4 4"
+#         "-DEXPECT=^game ;^(playing|won) " -P BotTest.cmake
+
+string(REPLACE ";" "\n" input "${REQUESTS}")
+set(inputFile "${CMAKE_CURRENT_BINARY_DIR}/bot-test-input.txt")
+file(WRITE "${inputFile}" "${input}\n")
+execute_process(COMMAND "${BOT}" INPUT_FILE "${inputFile}"
+  OUTPUT_VARIABLE output RESULT_VARIABLE result)
+file(REMOVE "${inputFile}")
+if(NOT result EQUAL 0)
+  message(FATAL_ERROR "bot exited with ${result}")
+endif()
+
+string(REGEX REPLACE "\n$" "" output "${output}")
+string(REPLACE "\n" ";" replies "${output}")
+list(LENGTH replies count)
+list(LENGTH EXPECT expected)
+if(NOT count EQUAL expected)
+  message(FATAL_ERROR "expected ${expected} replies, got ${count}")
+endif()
+foreach(i RANGE 1 ${count})
+  math(EXPR index "${i} - 1")
+  list(GET replies ${index} reply)
+  list(GET EXPECT ${index} pattern)
+  if(NOT reply MATCHES "${pattern}")
+    string(SUBSTRING "${reply}" 0 80 start)
+    message(FATAL_ERROR "reply ${i} \"${start}\" does not match ${pattern}")
+  endif()
+endforeach()
@@ -0,0 +1,66 @@
+# Writes the largest PNG image inside an .ico file to a C++ header as a
+# constexpr byte array, so the game needs no asset files at runtime.
+#
+#   cmake -DINPUT=flag.ico -DOUTPUT=FlagIcon.h -DNAME=flagIconPng
+#         -P EmbedIcon.cmake
+
+# Little-endian unsigned integer of `bytes` bytes at byte `offset` of `hex`.
+function(read_le hex offset bytes out)
+  set(value 0)
+  math(EXPR last "${bytes} - 1")
+  foreach(i RANGE ${last})
+    math(EXPR pos "(${offset} + ${last} - ${i}) * 2")
+    foreach(digit 0 1)
+      math(EXPR at "${pos} + ${digit}")
+      string(SUBSTRING "${hex}" ${at} 1 c)
+      string(FIND "0123456789abcdef" "${c}" nibble)
+      math(EXPR value "${value} * 16 + ${nibble}")
+    endforeach()
+  endforeach()
+  set(${out} ${value} PARENT_SCOPE)
+endfunction()
+
+file(READ "${INPUT}" header HEX LIMIT 6)
+read_le("${header}" 4 2 count)
+math(EXPR directorySize "6 + 16 * ${count}")
+file(READ "${INPUT}" directory HEX LIMIT ${directorySize})
+
+# ICO entries store a width of 256 as 0.
+set(bestWidth 0)
+math(EXPR lastEntry "${count} - 1")
+foreach(i RANGE ${lastEntry})
+  math(EXPR entry "6 + 16 * ${i}")
+  read_le("${directory}" ${entry} 1 width)
+  if(width EQUAL 0)
+    set(width 256)
+  endif()
+  math(EXPR sizeAt "${entry} + 8")
+  math(EXPR offsetAt "${entry} + 12")
+  read_le("${directory}" ${sizeAt} 4 size)
+  read_le("${directory}" ${offsetAt} 4 offset)
+  file(READ "${INPUT}" signature HEX OFFSET ${offset} LIMIT 8)
+  if(signature STREQUAL "89504e470d0a1a0a" AND width GREATER bestWidth)
+    set(bestWidth ${width})
+    set(bestSize ${size})
+    set(bestOffset ${offset})
+  endif()
+endforeach()
+if(bestWidth EQUAL 0)
+  message(FATAL_ERROR "${INPUT} contains no PNG image")
+endif()
+
+file(READ "${INPUT}" png HEX OFFSET ${bestOffset} LIMIT ${bestSize})
+string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," bytes "${png}")
+# Sixteen bytes per line; CMake regexes have no {n} repetition.
+set(row "")
+foreach(i RANGE 15)
+  string(APPEND row "0x..,")
+endforeach()
+string(REGEX REPLACE "(${row})" "\\1\n  " bytes "${bytes}")
+string(STRIP "${bytes}" bytes)
+get_filename_component(inputName "${INPUT}" NAME)
+file(WRITE "${OUTPUT}"
+  "// Generated by cmake/EmbedIcon.cmake from ${inputName}. Do not edit.\n"
+  "#pragma once\n\n"
+  "// ${bestWidth}x${bestWidth} PNG, ${bestSize} bytes.\n"
+  "constexpr unsigned char ${NAME}[] = {\n  ${bytes}\n};\n")
@@ -0,0 +1,17 @@
+# Runs the game headlessly on a trace with --assert-no-alloc and checks that
+# it exits cleanly with the board in the expected final state.
+#
+#   cmake -DGAME=Minesweeper -DTRACE=steady-play.trace
+#         "-DEXPECT=board: playing  revealed 54  mines left 97"
+#         -P TraceTest.cmake
+
+execute_process(COMMAND "${GAME}" --trace "${TRACE}" --assert-no-alloc
+  OUTPUT_VARIABLE output RESULT_VARIABLE result)
+message("${output}")
+if(NOT result EQUAL 0)
+  message(FATAL_ERROR "game exited with ${result}")
+endif()
+string(FIND "${output}" "${EXPECT}" found)
+if(found EQUAL -1)
+  message(FATAL_ERROR "expected \"${EXPECT}\" in the output")
+endif()
@@ -0,0 +1,31 @@
+# Prints the size of each web build output, raw and gzipped, so a change in
+# download size shows up in the build log.
+#
+#   cmake -DFILES="index.wasm;index.js" -P WebSize.cmake
+
+set(total 0)
+set(totalGzip 0)
+foreach(path ${FILES})
+  if(NOT EXISTS "${path}")
+    continue()
+  endif()
+  file(SIZE "${path}" size)
+  math(EXPR total "${total} + ${size}")
+
+  # Pages are served compressed, so the gzipped size is what users download.
+  set(archive "${path}.size.gz")
+  file(ARCHIVE_CREATE OUTPUT "${archive}" PATHS "${path}" FORMAT raw
+    COMPRESSION GZip)
+  file(SIZE "${archive}" gzipSize)
+  file(REMOVE "${archive}")
+  math(EXPR totalGzip "${totalGzip} + ${gzipSize}")
+
+  get_filename_component(name "${path}" NAME)
+  math(EXPR kib "(${size} + 512) / 1024")
+  math(EXPR gzipKib "(${gzipSize} + 512) / 1024")
+  message(STATUS "${name}: ${kib} KiB, ${gzipKib} KiB gzipped")
+endforeach()
+
+math(EXPR kib "(${total} + 512) / 1024")
+math(EXPR gzipKib "(${totalGzip} + 512) / 1024")
+message(STATUS "web total: ${kib} KiB, ${gzipKib} KiB gzipped")
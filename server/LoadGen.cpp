@@ -0,0 +1,275 @@
+// Load generator for MinesweeperServer. Opens many connections and keeps
+// each one playing: one request in flight per client, sent when the previous
+// reply arrives plus an optional think time, so the latencies reported are
+// per move. Without think time every client is always waiting, and latency
+// grows with the client count; a think time models players instead.
+//
+//   MinesweeperLoadGen [--connect 127.0.0.1:7777 | --connect unix:/path]
+//                      [--clients N] [--threads N] [--seconds N]
+//                      [--think MS] [--size N] [--mines N]
+
+#include "Net.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <string>
+#include <sys/epoll.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+  NetAddress address;
+  int clients = 1000;
+  int threads = 4;
+  int seconds = 10;
+  int thinkMs = 0;
+  int size = 16;
+  int mines = 40;
+};
+
+struct Client {
+  int fd = -1;
+  bool newGame = true; // next request starts a game rather than a move
+  Clock::time_point sent;
+  char in[128];
+  size_t inLength = 0;
+};
+
+struct ThreadResult {
+  std::vector<uint32_t> latenciesUs; // moves only, not NEW
+  uint64_t games = 0;
+  uint64_t errors = 0;
+  int connected = 0;
+  int connectError = 0; // errno of the first failed connect
+  double seconds = 0;   // measured after the clients connected
+};
+
+static bool Send(Client &client, const Options &options, std::mt19937 &rng) {
+  char request[64];
+  int length;
+  if (client.newGame) {
+    length = std::snprintf(request, sizeof(request), "NEW %d %d %d\n",
+                           options.size, options.size, options.mines);
+  } else {
+    // Mostly reveals, with some flags and chords mixed in.
+    static const char *const verbs[] = {"REVEAL", "REVEAL", "REVEAL", "FLAG",
+                                        "CHORD"};
+    int x = (int)(rng() % options.size);
+    int y = (int)(rng() % options.size);
+    length = std::snprintf(request, sizeof(request), "%s %d %d\n",
+                           verbs[rng() % 5], x, y);
+  }
+  client.sent = Clock::now();
+  // A request this short fits in an empty socket buffer in one send.
+  return send(client.fd, request, length, MSG_NOSIGNAL) == length;
+}
+
+// Reads what has arrived and sets `replied` once the reply line is complete.
+// Returns false if the connection failed.
+static bool Receive(Client &client, ThreadResult &result, bool &replied) {
+  replied = false;
+  ssize_t n = recv(client.fd, client.in + client.inLength,
+                   sizeof(client.in) - client.inLength, 0);
+  if (n < 0)
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+  if (n == 0)
+    return false;
+  client.inLength += n;
+  char *end =
+      static_cast<char *>(std::memchr(client.in, '\n', client.inLength));
+  if (end == nullptr)
+    return client.inLength < sizeof(client.in);
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+      Clock::now() - client.sent);
+  if (client.newGame) {
+    client.newGame = false;
+    result.games++;
+  } else {
+    result.latenciesUs.push_back((uint32_t)elapsed.count());
+    if (std::strncmp(client.in, "ERR", 3) == 0) {
+      // Moves on a finished board are refused; start the next game.
+      result.errors++;
+      client.newGame = true;
+    } else if (std::strncmp(client.in, "WON", 3) == 0 ||
+               std::strncmp(client.in, "LOST", 4) == 0) {
+      client.newGame = true;
+    }
+  }
+  client.inLength = 0;
+  replied = true;
+  return true;
+}
+
+static void RunClients(const Options &options, int count,
+                       ThreadResult &result) {
+  int epollFd = epoll_create1(EPOLL_CLOEXEC);
+  std::vector<Client> clients(count);
+  std::mt19937 rng(std::random_device{}());
+  result.latenciesUs.reserve(1 << 20);
+
+  for (int i = 0; i < count; i++) {
+    Client &client = clients[i];
+    client.fd = ConnectTo(options.address);
+    if (client.fd < 0) {
+      if (result.connectError == 0)
+        result.connectError = errno;
+      continue;
+    }
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u32 = (uint32_t)i;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, client.fd, &event);
+    result.connected++;
+  }
+
+  // Clients between a reply and their next move, due in the order they
+  // were queued since the think time is the same for all of them. First
+  // moves are spread over one think time so clients do not move in step.
+  std::deque<std::pair<Clock::time_point, int>> thinking;
+  auto think = std::chrono::milliseconds(options.thinkMs);
+  auto start = Clock::now();
+  auto deadline = start + std::chrono::seconds(options.seconds);
+  for (int i = 0; i < count; i++) {
+    if (clients[i].fd < 0)
+      continue;
+    if (options.thinkMs > 0)
+      thinking.emplace_back(start + think * i / count, i);
+    else
+      Send(clients[i], options, rng);
+  }
+  epoll_event events[256];
+  while (Clock::now() < deadline) {
+    int timeoutMs = 100;
+    if (!thinking.empty()) {
+      auto wait = std::chrono::ceil<std::chrono::milliseconds>(
+          thinking.front().first - Clock::now());
+      timeoutMs = (int)std::clamp<int64_t>(wait.count(), 0, 100);
+    }
+    int ready = epoll_wait(epollFd, events, 256, timeoutMs);
+    for (int i = 0; i < ready; i++) {
+      int index = (int)events[i].data.u32;
+      Client &client = clients[index];
+      if (client.fd < 0)
+        continue;
+      bool replied;
+      bool open = Receive(client, result, replied);
+      if (open && replied) {
+        if (options.thinkMs > 0)
+          thinking.emplace_back(Clock::now() + think, index);
+        else
+          open = Send(client, options, rng);
+      }
+      if (!open) {
+        close(client.fd);
+        client.fd = -1;
+        result.connected--;
+      }
+    }
+
+    auto now = Clock::now();
+    while (!thinking.empty() && thinking.front().first <= now) {
+      Client &client = clients[thinking.front().second];
+      thinking.pop_front();
+      if (client.fd >= 0 && !Send(client, options, rng)) {
+        close(client.fd);
+        client.fd = -1;
+        result.connected--;
+      }
+    }
+  }
+
+  result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  for (Client &client : clients) {
+    if (client.fd >= 0)
+      close(client.fd);
+  }
+  close(epollFd);
+}
+
+int main(int argc, char **argv) {
+  Options options;
+  std::string connectAddress = "127.0.0.1:7777";
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    if (i + 1 >= argc)
+      break;
+    if (std::strcmp(arg, "--connect") == 0) {
+      connectAddress = argv[++i];
+    } else if (std::strcmp(arg, "--clients") == 0) {
+      options.clients = std::max(1, std::atoi(argv[++i]));
+    } else if (std::strcmp(arg, "--threads") == 0) {
+      options.threads = std::max(1, std::atoi(argv[++i]));
+    } else if (std::strcmp(arg, "--seconds") == 0) {
+      options.seconds = std::max(1, std::atoi(argv[++i]));
+    } else if (std::strcmp(arg, "--think") == 0) {
+      options.thinkMs = std::max(0, std::atoi(argv[++i]));
+    } else if (std::strcmp(arg, "--size") == 0) {
+      options.size = std::atoi(argv[++i]);
+    } else if (std::strcmp(arg, "--mines") == 0) {
+      options.mines = std::atoi(argv[++i]);
+    }
+  }
+  if (!ParseAddress(connectAddress, options.address)) {
+    std::fprintf(stderr, "loadgen: bad address %s\n", connectAddress.c_str());
+    return 1;
+  }
+  options.threads = std::min(options.threads, options.clients);
+  RaiseFileLimit();
+
+  std::vector<ThreadResult> results(options.threads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < options.threads; t++) {
+    int count = options.clients / options.threads +
+                (t < options.clients % options.threads ? 1 : 0);
+    threads.emplace_back(RunClients, std::cref(options), count,
+                         std::ref(results[t]));
+  }
+  for (std::thread &thread : threads)
+    thread.join();
+
+  std::vector<uint32_t> latencies;
+  uint64_t games = 0, errors = 0;
+  int connected = 0, connectError = 0;
+  double movesPerSecond = 0;
+  for (const ThreadResult &result : results) {
+    latencies.insert(latencies.end(), result.latenciesUs.begin(),
+                     result.latenciesUs.end());
+    games += result.games;
+    errors += result.errors;
+    connected += result.connected;
+    movesPerSecond += result.latenciesUs.size() / result.seconds;
+    if (result.connectError != 0 && connected < options.clients)
+      connectError = result.connectError;
+  }
+  if (connectError != 0)
+    std::fprintf(stderr, "loadgen: some connects failed: %s\n",
+                 std::strerror(connectError));
+  if (latencies.empty()) {
+    std::fprintf(stderr, "loadgen: no moves completed\n");
+    return 1;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&](double p) {
+    return latencies[std::min(latencies.size() - 1,
+                              (size_t)(p * latencies.size()))];
+  };
+
+  std::printf("clients %d/%d  games %llu  moves %zu  refused %llu\n",
+              connected, options.clients, (unsigned long long)games,
+              latencies.size(), (unsigned long long)errors);
+  std::printf("moves/s %.0f\n", movesPerSecond);
+  std::printf("latency us  p50 %u  p99 %u  p99.9 %u  max %u\n",
+              percentile(0.50), percentile(0.99), percentile(0.999),
+              latencies.back());
+  return 0;
+}
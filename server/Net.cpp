@@ -0,0 +1,101 @@
+#include "Net.h"
+#include <arpa/inet.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/resource.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+bool ParseAddress(const std::string &text, NetAddress &address) {
+  address = NetAddress();
+  if (text.compare(0, 5, "unix:") == 0) {
+    sockaddr_un *un = reinterpret_cast<sockaddr_un *>(&address.storage);
+    address.unixPath = text.substr(5);
+    if (address.unixPath.empty() ||
+        address.unixPath.size() >= sizeof(un->sun_path))
+      return false;
+    un->sun_family = AF_UNIX;
+    std::memcpy(un->sun_path, address.unixPath.c_str(),
+                address.unixPath.size() + 1);
+    address.length = sizeof(sockaddr_un);
+    address.unixSocket = true;
+    return true;
+  }
+
+  size_t colon = text.rfind(':');
+  if (colon == std::string::npos)
+    return false;
+  std::string host = text.substr(0, colon);
+  std::string port = text.substr(colon + 1);
+  addrinfo hints = {};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo *result = nullptr;
+  if (getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints,
+                  &result) != 0)
+    return false;
+  std::memcpy(&address.storage, result->ai_addr, result->ai_addrlen);
+  address.length = result->ai_addrlen;
+  freeaddrinfo(result);
+  return true;
+}
+
+bool SetNonBlocking(int fd) {
+  int flags = fcntl(fd, F_GETFL, 0);
+  return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+void SetNoDelay(int fd) {
+  // Replies are single short lines; Nagle would hold each one back.
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+int ListenOn(const NetAddress &address) {
+  int family = address.storage.ss_family;
+  int fd = socket(family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0)
+    return -1;
+  if (address.unixSocket) {
+    unlink(address.unixPath.c_str());
+  } else {
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  }
+  if (bind(fd, reinterpret_cast<const sockaddr *>(&address.storage),
+           address.length) != 0 ||
+      listen(fd, SOMAXCONN) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int ConnectTo(const NetAddress &address) {
+  int fd = socket(address.storage.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0)
+    return -1;
+  if (connect(fd, reinterpret_cast<const sockaddr *>(&address.storage),
+              address.length) != 0 ||
+      !SetNonBlocking(fd)) {
+    close(fd);
+    return -1;
+  }
+  if (!address.unixSocket)
+    SetNoDelay(fd);
+  return fd;
+}
+
+void RaiseFileLimit() {
+  rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) == 0 &&
+      limit.rlim_cur < limit.rlim_max) {
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <string>
+#include <sys/socket.h>
+
+// Socket helpers shared by the server and the load generator. Addresses are
+// "host:port" for TCP or "unix:/path" for a Unix domain socket.
+struct NetAddress {
+  sockaddr_storage storage = {};
+  socklen_t length = 0;
+  bool unixSocket = false;
+  std::string unixPath;
+};
+
+bool ParseAddress(const std::string &text, NetAddress &address);
+// Non-blocking listening socket; a stale Unix socket file is replaced.
+int ListenOn(const NetAddress &address);
+// Blocking connect, then switched to non-blocking with Nagle disabled.
+int ConnectTo(const NetAddress &address);
+bool SetNonBlocking(int fd);
+void SetNoDelay(int fd);
+// Thousands of sessions need thousands of descriptors; raises the soft
+// limit to the hard one.
+void RaiseFileLimit();
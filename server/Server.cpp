@@ -0,0 +1,286 @@
+// Headless Minesweeper server: every connection plays its own board, with
+// each move applied and checked by Board on the server. One worker thread
+// per core runs its own epoll loop over its own preallocated sessions; all
+// of them wait on the shared listening socket.
+//
+//   MinesweeperServer [--listen 127.0.0.1:7777 | --listen unix:/path]
+//                     [--workers N] [--sessions N]
+//
+// The protocol is described in Session.h.
+
+#include "Net.h"
+#include "Session.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <sys/epoll.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+static const uint32_t listenTag = UINT32_MAX;
+static std::atomic<bool> stopping{false};
+
+class Worker {
+public:
+  Worker(int listenFd, bool tcp, size_t capacity)
+      : listenFd(listenFd), tcp(tcp), capacity(capacity), pool(capacity) {}
+  ~Worker() {
+    if (epollFd >= 0)
+      close(epollFd);
+  }
+
+  bool Start();
+  void Join() { thread.join(); }
+
+  std::atomic<uint64_t> moves{0};
+  std::atomic<size_t> sessions{0};
+
+private:
+  void Run();
+  void Accept();
+  bool Service(Session &session);
+  bool Flush(Session &session);
+  void Close(uint32_t index);
+  bool Listen(bool enable);
+
+  int listenFd;
+  bool tcp;
+  int epollFd = -1;
+  bool listening = false;
+  size_t capacity;
+  SessionPool pool;
+  std::thread thread;
+};
+
+bool Worker::Start() {
+  epollFd = epoll_create1(EPOLL_CLOEXEC);
+  if (epollFd < 0 || !Listen(true))
+    return false;
+  thread = std::thread(&Worker::Run, this);
+  return true;
+}
+
+// A worker with no free sessions stops waiting on the listening socket, so
+// new connections go to workers that can take them.
+bool Worker::Listen(bool enable) {
+  if (enable == listening)
+    return true;
+  // EPOLLEXCLUSIVE wakes one waiting worker per connection instead of all.
+  epoll_event event = {};
+  event.events = EPOLLIN | EPOLLEXCLUSIVE;
+  event.data.u32 = listenTag;
+  int op = enable ? EPOLL_CTL_ADD : EPOLL_CTL_DEL;
+  if (epoll_ctl(epollFd, op, listenFd, &event) != 0)
+    return false;
+  listening = enable;
+  return true;
+}
+
+void Worker::Run() {
+  epoll_event events[256];
+  while (!stopping.load(std::memory_order_relaxed)) {
+    int count = epoll_wait(epollFd, events, 256, 200);
+    uint64_t handled = 0;
+    for (int i = 0; i < count; i++) {
+      uint32_t index = events[i].data.u32;
+      if (index == listenTag) {
+        Accept();
+        continue;
+      }
+
+      Session &session = pool[index];
+      bool open = (events[i].events & (EPOLLERR | EPOLLHUP)) == 0;
+      if (open && (events[i].events & EPOLLIN)) {
+        // Leaves any bytes that do not fit for after the buffered lines
+        // have been answered.
+        while (session.inLength < sizeof(session.in)) {
+          ssize_t n = recv(session.fd, session.in + session.inLength,
+                           sizeof(session.in) - session.inLength, 0);
+          if (n > 0) {
+            session.inLength += n;
+          } else {
+            open = n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+            break;
+          }
+        }
+      }
+      if (open)
+        open = session.ProcessInput(handled) && Service(session);
+      if (!open)
+        Close(index);
+    }
+    if (handled > 0)
+      moves.fetch_add(handled, std::memory_order_relaxed);
+  }
+
+  for (uint32_t i = 0; pool.InUse() > 0; i++) {
+    if (pool[i].fd >= 0)
+      Close(i);
+  }
+}
+
+void Worker::Accept() {
+  // One connection per wakeup: the socket stays readable while more are
+  // queued, so a burst of connections spreads across the workers.
+  int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+  if (fd < 0)
+    return;
+  uint32_t index;
+  if (!pool.Acquire(fd, index)) {
+    static const char full[] = "ERR server full\n";
+    send(fd, full, sizeof(full) - 1, MSG_NOSIGNAL);
+    close(fd);
+    return;
+  }
+  if (tcp)
+    SetNoDelay(fd);
+
+  Session &session = pool[index];
+  epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.u32 = index;
+  if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+    close(fd);
+    pool.Release(index);
+    return;
+  }
+  session.events = EPOLLIN;
+  sessions.fetch_add(1, std::memory_order_relaxed);
+  if (pool.InUse() == capacity)
+    Listen(false);
+}
+
+// Sends what ProcessInput queued and answers any lines it had to hold back
+// for lack of room. While replies are stuck, the session waits for the
+// socket to drain instead of reading more requests.
+bool Worker::Service(Session &session) {
+  uint64_t handled = 0;
+  while (true) {
+    if (!Flush(session))
+      return false;
+    if (session.outLength > 0 || session.inLength == 0)
+      break;
+    size_t before = session.inLength;
+    if (!session.ProcessInput(handled))
+      return false;
+    if (session.inLength == before && session.outLength == 0)
+      break;
+  }
+  if (handled > 0)
+    moves.fetch_add(handled, std::memory_order_relaxed);
+  if (session.closing && session.outLength == 0)
+    return false;
+
+  uint32_t want = session.outLength > 0 ? EPOLLOUT : EPOLLIN;
+  if (want != session.events) {
+    epoll_event event = {};
+    event.events = want;
+    event.data.u32 = (uint32_t)(&session - &pool[0]);
+    if (epoll_ctl(epollFd, EPOLL_CTL_MOD, session.fd, &event) != 0)
+      return false;
+    session.events = want;
+  }
+  return true;
+}
+
+bool Worker::Flush(Session &session) {
+  while (session.outLength > 0) {
+    ssize_t n = send(session.fd, session.out + session.outStart,
+                     session.outLength, MSG_NOSIGNAL);
+    if (n < 0)
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    session.outStart += n;
+    session.outLength -= n;
+  }
+  session.outStart = 0;
+  return true;
+}
+
+void Worker::Close(uint32_t index) {
+  // Closing the descriptor also drops it from the epoll set.
+  close(pool[index].fd);
+  pool.Release(index);
+  sessions.fetch_sub(1, std::memory_order_relaxed);
+  Listen(true);
+}
+
+int main(int argc, char **argv) {
+  std::string listenAddress = "127.0.0.1:7777";
+  int workerCount = (int)std::max(1u, std::thread::hardware_concurrency());
+  size_t sessionCount = 65536;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--listen") == 0 && i + 1 < argc) {
+      listenAddress = argv[++i];
+    } else if (std::strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+      workerCount = std::max(1, std::atoi(argv[++i]));
+    } else if (std::strcmp(argv[i], "--sessions") == 0 && i + 1 < argc) {
+      sessionCount = (size_t)std::max(1, std::atoi(argv[++i]));
+    }
+  }
+
+  NetAddress address;
+  if (!ParseAddress(listenAddress, address)) {
+    std::fprintf(stderr, "server: bad address %s\n", listenAddress.c_str());
+    return 1;
+  }
+  RaiseFileLimit();
+  int listenFd = ListenOn(address);
+  if (listenFd < 0) {
+    std::fprintf(stderr, "server: cannot listen on %s: %s\n",
+                 listenAddress.c_str(), std::strerror(errno));
+    return 1;
+  }
+
+  // Workers inherit the blocked signals; only main waits for them.
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+  size_t perWorker = (sessionCount + workerCount - 1) / workerCount;
+  std::vector<std::unique_ptr<Worker>> workers;
+  for (int i = 0; i < workerCount; i++) {
+    workers.push_back(
+        std::make_unique<Worker>(listenFd, !address.unixSocket, perWorker));
+    if (!workers.back()->Start()) {
+      std::fprintf(stderr, "server: cannot start worker: %s\n",
+                   std::strerror(errno));
+      return 1;
+    }
+  }
+  std::printf("listening on %s, %d workers, %zu sessions each\n",
+              listenAddress.c_str(), workerCount, perWorker);
+  std::fflush(stdout);
+
+  // Reports load every five seconds until interrupted.
+  uint64_t lastMoves = 0;
+  timespec interval = {5, 0};
+  while (sigtimedwait(&signals, nullptr, &interval) < 0) {
+    uint64_t moves = 0;
+    size_t sessions = 0;
+    for (const auto &worker : workers) {
+      moves += worker->moves.load(std::memory_order_relaxed);
+      sessions += worker->sessions.load(std::memory_order_relaxed);
+    }
+    std::printf("sessions %zu  moves/s %.0f\n", sessions,
+                (moves - lastMoves) / 5.0);
+    std::fflush(stdout);
+    lastMoves = moves;
+  }
+
+  stopping = true;
+  for (auto &worker : workers)
+    worker->Join();
+  close(listenFd);
+  if (address.unixSocket)
+    unlink(address.unixPath.c_str());
+  return 0;
+}
@@ -0,0 +1,196 @@
+#include "Session.h"
+#include "Replay.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+void Session::Reset(int fd) {
+  this->fd = fd;
+  events = 0;
+  hasGame = false;
+  noGuess = false;
+  closing = false;
+  inLength = 0;
+  outStart = 0;
+  outLength = 0;
+}
+
+bool Session::ProcessInput(uint64_t &moves) {
+  size_t consumed = 0;
+  while (!closing) {
+    char *begin = in + consumed;
+    char *end =
+        static_cast<char *>(std::memchr(begin, '\n', inLength - consumed));
+    if (end == nullptr)
+      break;
+
+    if (sizeof(out) - outStart - outLength < maxReplySize) {
+      if (outStart == 0)
+        break;
+      std::memmove(out, out + outStart, outLength);
+      outStart = 0;
+      if (sizeof(out) - outLength < maxReplySize)
+        break;
+    }
+
+    *end = '\0';
+    if (end > begin && end[-1] == '\r')
+      end[-1] = '\0';
+    HandleLine(begin, moves);
+    consumed = end + 1 - in;
+  }
+
+  std::memmove(in, in + consumed, inLength - consumed);
+  inLength -= consumed;
+  // A full buffer with no newline is not a request this protocol sends.
+  return inLength < sizeof(in);
+}
+
+void Session::Reply(const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  char *at = out + outStart + outLength;
+  size_t space = sizeof(out) - outStart - outLength;
+  int written = std::vsnprintf(at, space, format, args);
+  va_end(args);
+  if (written > 0)
+    outLength += std::min((size_t)written, space - 1);
+}
+
+static bool ParseInt(const char *text, int &value) {
+  if (text == nullptr)
+    return false;
+  // Values that do not fit an int are rejected rather than wrapped.
+  const char *end = text + std::strlen(text);
+  auto result = std::from_chars(text, end, value);
+  return result.ec == std::errc() && result.ptr == end;
+}
+
+void Session::HandleLine(char *line, uint64_t &moves) {
+  // Split into at most five space-separated words in place.
+  char *words[5] = {};
+  int count = 0;
+  char *rest = nullptr;
+  char *token = strtok_r(line, " ", &rest);
+  while (token != nullptr && count < 5) {
+    words[count++] = token;
+    token = strtok_r(nullptr, " ", &rest);
+  }
+  if (count == 0) {
+    Reply("ERR empty request\n");
+    return;
+  }
+  const char *verb = words[0];
+
+  if (std::strcmp(verb, "NEW") == 0) {
+    int w, h, mines;
+    if (!ParseInt(words[1], w) || !ParseInt(words[2], h) ||
+        !ParseInt(words[3], mines)) {
+      Reply("ERR usage: NEW <w> <h> <mines> [noguess]\n");
+      return;
+    }
+    // The first click keeps a 3x3 area clear of mines.
+    if (w < 4 || h < 4 || w > maxBoardSide || h > maxBoardSide ||
+        mines < 1 || mines > w * h - 9) {
+      Reply("ERR board must be 4-%d a side with 1 to w*h-9 mines\n",
+            maxBoardSide);
+      return;
+    }
+    if (w == board.GetWidth() && h == board.GetHeight() &&
+        mines == board.GetTotalMines()) {
+      board.Reset();
+    } else {
+      board.Resize(w, h, mines);
+    }
+    noGuess = words[4] != nullptr && std::strcmp(words[4], "noguess") == 0;
+    hasGame = true;
+    Reply("GAME %d %d %d\n", w, h, mines);
+    return;
+  }
+
+  if (std::strcmp(verb, "VIEW") == 0) {
+    if (!hasGame) {
+      Reply("ERR no game\n");
+      return;
+    }
+    Reply("BOARD %d %d ", board.GetWidth(), board.GetHeight());
+    char *cells = out + outStart + outLength;
+    for (int y = 0; y < board.GetHeight(); y++) {
+      for (int x = 0; x < board.GetWidth(); x++) {
+        const Cell &cell = board.GetCell(x, y);
+        *cells++ = !cell.isRevealed ? (cell.isFlagged ? 'F' : '#')
+                   : cell.isMine    ? '*'
+                                    : (char)('0' + cell.neighborMines);
+      }
+    }
+    *cells++ = '\n';
+    outLength = cells - (out + outStart);
+    return;
+  }
+
+  if (std::strcmp(verb, "QUIT") == 0) {
+    closing = true;
+    return;
+  }
+
+  ReplayAction action;
+  if (std::strcmp(verb, "REVEAL") == 0) {
+    action = ReplayAction::REVEAL;
+  } else if (std::strcmp(verb, "FLAG") == 0) {
+    action = ReplayAction::FLAG;
+  } else if (std::strcmp(verb, "CHORD") == 0) {
+    action = ReplayAction::CHORD;
+  } else {
+    Reply("ERR unknown request\n");
+    return;
+  }
+
+  int x, y;
+  if (!ParseInt(words[1], x) || !ParseInt(words[2], y)) {
+    Reply("ERR usage: %s <x> <y>\n", verb);
+    return;
+  }
+  if (!hasGame) {
+    Reply("ERR no game\n");
+    return;
+  }
+  if (!board.IsValid(x, y)) {
+    Reply("ERR cell out of range\n");
+    return;
+  }
+  if (board.IsGameOver()) {
+    Reply("ERR game over\n");
+    return;
+  }
+  // First reveals go through the same path as the game, so no-guess boards
+  // are generated identically.
+  ApplyReplayAction(board, action, x, y, noGuess);
+  moves++;
+  const char *state = board.IsGameWon()    ? "WON"
+                      : board.IsGameOver() ? "LOST"
+                                           : "PLAYING";
+  Reply("%s %d %d\n", state, board.GetRevealedCount(), board.GetMinesLeft());
+}
+
+SessionPool::SessionPool(size_t capacity) : sessions(capacity) {
+  freeList.reserve(capacity);
+  // Handed out lowest index first, keeping busy sessions close together.
+  for (size_t i = capacity; i > 0; i--)
+    freeList.push_back((uint32_t)(i - 1));
+}
+
+bool SessionPool::Acquire(int fd, uint32_t &index) {
+  if (freeList.empty())
+    return false;
+  index = freeList.back();
+  freeList.pop_back();
+  sessions[index].Reset(fd);
+  return true;
+}
+
+void SessionPool::Release(uint32_t index) {
+  sessions[index].fd = -1;
+  freeList.push_back(index);
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "Board.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Line protocol, one request and one reply per line:
+//
+//   NEW <w> <h> <mines> [noguess]  ->  GAME <w> <h> <mines>
+//   REVEAL|FLAG|CHORD <x> <y>      ->  PLAYING|WON|LOST <revealed> <left>
+//   VIEW                           ->  BOARD <w> <h> <cells>
+//   QUIT                               closes the connection
+//
+// Cells in a VIEW are '#' hidden, 'F' flagged, '*' mine, '0'-'8' numbers.
+// Bad requests get "ERR <reason>" and leave the session as it was.
+
+// Largest board a client may start. Bounds each session's memory and the
+// size of a VIEW reply, which every session must have room to buffer.
+constexpr int maxBoardSide = 48;
+constexpr size_t maxReplySize = maxBoardSide * maxBoardSide + 32;
+
+struct Session {
+  int fd = -1;
+  uint32_t events = 0; // epoll interest currently registered
+  // Kept between connections; Resize reuses its storage once grown, so the
+  // pool starts every board small.
+  Board board{9, 9, 10};
+  bool hasGame = false;
+  bool noGuess = false;
+  bool closing = false; // QUIT received; close once replies are sent
+
+  char in[256];
+  size_t inLength = 0;
+  char out[maxReplySize + 512]; // a VIEW plus pipelined short replies
+  size_t outStart = 0;
+  size_t outLength = 0;
+
+  void Reset(int fd);
+  // Answers complete request lines while a reply of any size still fits in
+  // `out`; the rest wait for the socket to drain. Returns false when the
+  // connection should be dropped.
+  bool ProcessInput(uint64_t &moves);
+
+private:
+  void HandleLine(char *line, uint64_t &moves);
+  void Reply(const char *format, ...);
+};
+
+// Sessions preallocated up front with a free list of indices, so accepting
+// a connection or starting a game allocates nothing.
+class SessionPool {
+public:
+  explicit SessionPool(size_t capacity);
+
+  // Returns false when every session is in use.
+  bool Acquire(int fd, uint32_t &index);
+  void Release(uint32_t index);
+  Session &operator[](uint32_t index) { return sessions[index]; }
+  size_t InUse() const { return sessions.size() - freeList.size(); }
+
+private:
+  std::vector<Session> sessions;
+  std::vector<uint32_t> freeList;
+};
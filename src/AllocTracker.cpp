@@ -0,0 +1,76 @@
+#include "AllocTracker.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<size_t> frameCounts[ALLOC_SUBSYSTEM_COUNT];
+static std::atomic<size_t> totalCounts[ALLOC_SUBSYSTEM_COUNT];
+static thread_local AllocSubsystem currentSubsystem = ALLOC_OTHER;
+
+bool AllocTracker::IsEnabled() {
+#if defined(MINESWEEPER_ALLOC_TRACKING)
+  return true;
+#else
+  return false;
+#endif
+}
+
+void AllocTracker::Count() {
+  frameCounts[currentSubsystem].fetch_add(1, std::memory_order_relaxed);
+  totalCounts[currentSubsystem].fetch_add(1, std::memory_order_relaxed);
+}
+
+void AllocTracker::BeginFrame() {
+  for (auto &count : frameCounts)
+    count.store(0, std::memory_order_relaxed);
+}
+
+size_t AllocTracker::GetFrameCount(AllocSubsystem subsystem) {
+  return frameCounts[subsystem].load(std::memory_order_relaxed);
+}
+
+size_t AllocTracker::GetTotal(AllocSubsystem subsystem) {
+  return totalCounts[subsystem].load(std::memory_order_relaxed);
+}
+
+size_t AllocTracker::GetFrameSteadyCount() {
+  return GetFrameCount(ALLOC_INPUT) + GetFrameCount(ALLOC_UPDATE) +
+         GetFrameCount(ALLOC_DRAW);
+}
+
+AllocSubsystem AllocTracker::GetSubsystem() { return currentSubsystem; }
+
+void AllocTracker::SetSubsystem(AllocSubsystem subsystem) {
+  currentSubsystem = subsystem;
+}
+
+const char *AllocTracker::GetName(AllocSubsystem subsystem) {
+  static const char *names[ALLOC_SUBSYSTEM_COUNT] = {
+      "other", "input", "update", "draw", "generate", "resources", "storage"};
+  return names[subsystem];
+}
+
+#if defined(MINESWEEPER_ALLOC_TRACKING)
+void *operator new(std::size_t size) {
+  AllocTracker::Count();
+  if (void *p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) { return operator new(size); }
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  AllocTracker::Count();
+  return std::malloc(size ? size : 1);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &tag) noexcept {
+  return operator new(size, tag);
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+#endif
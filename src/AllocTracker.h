@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+
+// Where a heap allocation happened. INPUT, UPDATE and DRAW are the per-frame
+// paths that must not allocate once a game is under way; the rest cover
+// one-off work such as generating a board, (re)creating GPU resources and
+// writing files.
+enum AllocSubsystem {
+  ALLOC_OTHER = 0,
+  ALLOC_INPUT,
+  ALLOC_UPDATE,
+  ALLOC_DRAW,
+  ALLOC_GENERATE,
+  ALLOC_RESOURCES,
+  ALLOC_STORAGE,
+  ALLOC_SUBSYSTEM_COUNT
+};
+
+// Counts heap allocations per frame and per subsystem. The counts are fed by
+// a replacement global operator new that is only compiled in with the
+// MINESWEEPER_ALLOC_TRACKING CMake option; otherwise they stay zero.
+class AllocTracker {
+public:
+  static bool IsEnabled();
+  static void Count();
+
+  // Clears the per-frame counts; totals keep accumulating.
+  static void BeginFrame();
+  static size_t GetFrameCount(AllocSubsystem subsystem);
+  static size_t GetTotal(AllocSubsystem subsystem);
+  // Allocations this frame on the paths that must stay allocation-free.
+  static size_t GetFrameSteadyCount();
+
+  static AllocSubsystem GetSubsystem();
+  static void SetSubsystem(AllocSubsystem subsystem);
+  static const char *GetName(AllocSubsystem subsystem);
+};
+
+// Attributes allocations on this thread to `subsystem` until it goes out of
+// scope.
+class AllocScope {
+public:
+  explicit AllocScope(AllocSubsystem subsystem)
+      : previous(AllocTracker::GetSubsystem()) {
+    AllocTracker::SetSubsystem(subsystem);
+  }
+  ~AllocScope() { AllocTracker::SetSubsystem(previous); }
+  AllocScope(const AllocScope &) = delete;
+  AllocScope &operator=(const AllocScope &) = delete;
+
+private:
+  AllocSubsystem previous;
+};
@@ -0,0 +1,21 @@
+#include "Assets.h"
+#include "FlagIcon.h"
+
+static Image flagImage = {};
+static bool flagDecoded = false;
+
+const Image &Assets::GetFlagImage() {
+  if (!flagDecoded) {
+    flagImage = LoadImageFromMemory(".png", flagIconPng,
+                                    (int)sizeof(flagIconPng));
+    flagDecoded = true;
+  }
+  return flagImage;
+}
+
+void Assets::Unload() {
+  if (flagImage.data != nullptr)
+    UnloadImage(flagImage);
+  flagImage = {};
+  flagDecoded = false;
+}
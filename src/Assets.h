@@ -0,0 +1,12 @@
+#pragma once
+#include "raylib.h"
+
+// Images compiled into the binary by cmake/EmbedIcon.cmake, so startup reads
+// no asset files. Each is decoded once, on first use, and shared.
+class Assets {
+public:
+  // The flag from flag.ico as a 256x256 RGBA image. Its data is null if the
+  // embedded PNG failed to decode.
+  static const Image &GetFlagImage();
+  static void Unload();
+};
@@ -1,26 +1,152 @@
 #include "Board.h"
+#include "Trace.h"
 #include <algorithm>
-#include <ctime>
+#include <cstring>
+#include <memory>
 #include <random>
 
+static const char boardMagic[4] = {'M', 'S', 'B', 'D'};
+static const uint32_t boardVersion = 2;
+
 Board::Board(int width, int height, int mines)
-    : width(width), height(height), totalMines(mines), firstClick(true),
-      gameOver(false), gameWon(false) {
-  grid.resize(height, std::vector<Cell>(width));
+    : width(width), height(height), totalMines(mines) {
+  tilesX = (width + tileSize - 1) / tileSize;
+  tilesY = (height + tileSize - 1) / tileSize;
+  heapStorage.resize(StorageSize());
+  BindStorage(heapStorage.data());
+  InitStorage();
+  // Enough for any opening on boards up to a million cells, so reveals do not
+  // allocate mid-game.
+  floodStack.reserve(std::min(width * height, 1 << 20));
+}
+
+void Board::Reset() { InitStorage(); }
+
+void Board::Resize(int width, int height, int mines) {
+  this->width = width;
+  this->height = height;
+  totalMines = mines;
+  tilesX = (width + tileSize - 1) / tileSize;
+  tilesY = (height + tileSize - 1) / tileSize;
+
+  mapped.Close();
+  heapStorage.resize(StorageSize());
+  BindStorage(heapStorage.data());
+  InitStorage();
+  floodStack.reserve(std::min(width * height, 1 << 20));
+  // The stored board no longer matches, so the file starts over from the
+  // fresh one.
+  if (!storagePath.empty())
+    OpenStorage(storagePath);
+}
+
+size_t Board::StorageSize() const {
+  return sizeof(BoardHeader) + sizeof(Tile) * tilesX * tilesY +
+         sizeof(Cell) * width * height;
+}
+
+void Board::BindStorage(unsigned char *base) {
+  header = reinterpret_cast<BoardHeader *>(base);
+  tiles = reinterpret_cast<Tile *>(base + sizeof(BoardHeader));
+  cells = reinterpret_cast<Cell *>(base + sizeof(BoardHeader) +
+                                   sizeof(Tile) * tilesX * tilesY);
+}
+
+void Board::InitStorage() {
+  std::memset(header, 0, sizeof(BoardHeader));
+  std::memcpy(header->magic, boardMagic, sizeof(boardMagic));
+  header->version = boardVersion;
+  header->width = width;
+  header->height = height;
+  header->totalMines = totalMines;
+  header->firstClick = true;
+  header->clickedMineX = -1;
+  header->clickedMineY = -1;
+  header->seed = std::random_device()();
+  std::uninitialized_fill_n(cells, width * height, Cell());
+  RebuildTiles();
+  // Sized here so labelling openings at the first click does not allocate.
+  openingOf.assign(width * height, noOpening);
+  openingSolved.resize(width * height);
+  bbbv = 0;
+  solvedBBBV = 0;
 }
 
-void Board::Reset() {
-  grid.assign(height, std::vector<Cell>(width));
-  firstClick = true;
-  gameOver = false;
-  gameWon = false;
-  clickedMineX = -1;
-  clickedMineY = -1;
+bool Board::IsStoredBoardValid(const unsigned char *base) const {
+  const BoardHeader *stored = reinterpret_cast<const BoardHeader *>(base);
+  return std::memcmp(stored->magic, boardMagic, sizeof(boardMagic)) == 0 &&
+         stored->version == boardVersion && stored->width == width &&
+         stored->height == height && stored->totalMines == totalMines;
+}
+
+bool Board::OpenStorage(const std::string &path) {
+  storagePath = path;
+  bool existed = false;
+  if (!mapped.Open(path, StorageSize(), existed))
+    return false;
+
+  // A fresh mapping starts from the current in-memory board, so switching
+  // storage mid-session does not lose state.
+  if (!existed || !IsStoredBoardValid(mapped.Data())) {
+    std::memcpy(mapped.Data(), heapStorage.data(), StorageSize());
+    existed = false;
+  }
+
+  BindStorage(mapped.Data());
+  if (existed)
+    RestoreOpenings();
+  heapStorage.clear();
+  heapStorage.shrink_to_fit();
+  return existed;
+}
+
+size_t Board::PackedStateSize() const {
+  return 1 + 2 * sizeof(int32_t) + (size_t)width * height;
+}
+
+// Layout: flags byte, clicked mine x/y as little-endian int32, then one byte
+// per cell (bit 0 mine, bit 1 revealed, bit 2 flagged, high nibble number).
+void Board::PackState(unsigned char *out) const {
+  out[0] = (header->firstClick ? 1 : 0) | (header->gameOver ? 2 : 0) |
+           (header->gameWon ? 4 : 0);
+  std::memcpy(out + 1, &header->clickedMineX, sizeof(int32_t));
+  std::memcpy(out + 1 + sizeof(int32_t), &header->clickedMineY,
+              sizeof(int32_t));
+  unsigned char *packed = out + 1 + 2 * sizeof(int32_t);
+  for (int i = 0; i < width * height; i++) {
+    const Cell &cell = cells[i];
+    packed[i] = (cell.isMine ? 1 : 0) | (cell.isRevealed ? 2 : 0) |
+                (cell.isFlagged ? 4 : 0) | (cell.neighborMines << 4);
+  }
+}
+
+void Board::UnpackState(const unsigned char *in) {
+  header->firstClick = (in[0] & 1) != 0;
+  header->gameOver = (in[0] & 2) != 0;
+  header->gameWon = (in[0] & 4) != 0;
+  std::memcpy(&header->clickedMineX, in + 1, sizeof(int32_t));
+  std::memcpy(&header->clickedMineY, in + 1 + sizeof(int32_t),
+              sizeof(int32_t));
+  const unsigned char *packed = in + 1 + 2 * sizeof(int32_t);
+  for (int i = 0; i < width * height; i++) {
+    Cell &cell = cells[i];
+    cell.isMine = (packed[i] & 1) != 0;
+    cell.isRevealed = (packed[i] & 2) != 0;
+    cell.isFlagged = (packed[i] & 4) != 0;
+    cell.neighborMines = packed[i] >> 4;
+  }
+  RebuildTiles();
+  RestoreOpenings();
+}
+
+void Board::Sync() {
+  if (mapped.IsOpen())
+    mapped.Flush();
 }
 
 const Cell &Board::GetCell(int x, int y) const {
   if (IsValid(x, y)) {
-    return grid[y][x];
+    return cells[y * width + x];
   }
   static Cell empty;
   return empty;
@@ -31,35 +157,38 @@ bool Board::IsValid(int x, int y) const {
 }
 
 void Board::ToggleFlag(int x, int y) {
-  if (!IsValid(x, y) || gameOver || gameWon)
+  if (!IsValid(x, y) || header->gameOver || header->gameWon)
     return;
 
-  Cell &cell = grid[y][x];
+  Cell &cell = At(x, y);
   if (!cell.isRevealed) {
-    cell.isFlagged = !cell.isFlagged;
+    SetFlagged(x, y, !cell.isFlagged);
   }
 }
 
 void Board::Reveal(int x, int y) {
-  if (!IsValid(x, y) || gameOver || gameWon)
+  if (!IsValid(x, y) || header->gameOver || header->gameWon)
     return;
+  TRACE_SCOPE("Board::Reveal");
 
-  Cell &cell = grid[y][x];
+  Cell &cell = At(x, y);
 
   if (cell.isFlagged || cell.isRevealed)
     return;
 
-  if (firstClick) {
+  if (header->firstClick) {
     PlaceMines(x, y);
     CalculateNumbers();
-    firstClick = false;
+    RebuildTiles();
+    LabelOpenings();
+    header->firstClick = false;
   }
 
   if (cell.isMine) {
-    cell.isRevealed = true;
-    gameOver = true;
-    clickedMineX = x;
-    clickedMineY = y;
+    SetRevealed(x, y);
+    header->gameOver = true;
+    header->clickedMineX = x;
+    header->clickedMineY = y;
     RevealAllMines();
     return;
   }
@@ -69,10 +198,10 @@ void Board::Reveal(int x, int y) {
 }
 
 void Board::Chord(int x, int y) {
-  if (!IsValid(x, y) || gameOver || gameWon)
+  if (!IsValid(x, y) || header->gameOver || header->gameWon)
     return;
 
-  Cell &cell = grid[y][x];
+  Cell &cell = At(x, y);
   if (!cell.isRevealed || cell.neighborMines == 0)
     return;
 
@@ -83,7 +212,7 @@ void Board::Chord(int x, int y) {
         continue;
       int nx = x + dx;
       int ny = y + dy;
-      if (IsValid(nx, ny) && grid[ny][nx].isFlagged) {
+      if (IsValid(nx, ny) && At(nx, ny).isFlagged) {
         flagCount++;
       }
     }
@@ -101,30 +230,42 @@ void Board::Chord(int x, int y) {
 }
 
 void Board::FloodFill(int x, int y) {
-  if (!IsValid(x, y))
-    return;
-  Cell &cell = grid[y][x];
-
-  if (cell.isRevealed || cell.isFlagged)
-    return;
-
-  cell.isRevealed = true;
+  TRACE_SCOPE("Board::FloodFill");
+  // Explicit stack: an opening on a large sparse board can span millions of
+  // cells, far deeper than the call stack allows. Cells are revealed as they
+  // are pushed so each one enters the stack at most once.
+  auto visit = [this](int cx, int cy) {
+    Cell &cell = At(cx, cy);
+    if (cell.isRevealed || cell.isFlagged)
+      return;
+    SetRevealed(cx, cy);
+    if (cell.neighborMines == 0)
+      floodStack.push_back(cy * width + cx);
+  };
 
-  if (cell.neighborMines == 0) {
+  floodStack.clear();
+  visit(x, y);
+  while (!floodStack.empty()) {
+    int index = floodStack.back();
+    floodStack.pop_back();
+    int cx = index % width;
+    int cy = index / width;
     for (int dy = -1; dy <= 1; dy++) {
       for (int dx = -1; dx <= 1; dx++) {
-        if (dx != 0 || dy != 0) {
-          FloodFill(x + dx, y + dy);
-        }
+        if ((dx != 0 || dy != 0) && IsValid(cx + dx, cy + dy))
+          visit(cx + dx, cy + dy);
       }
     }
   }
 }
 
 void Board::PlaceMines(int safeX, int safeY) {
+  for (int i = 0; i < width * height; i++) {
+    cells[i].isMine = false;
+  }
+
   int minesPlaced = 0;
-  std::random_device rd;
-  std::mt19937 rng(rd());
+  std::mt19937 rng(header->seed);
   std::uniform_int_distribution<int> distX(0, width - 1);
   std::uniform_int_distribution<int> distY(0, height - 1);
 
@@ -135,56 +276,55 @@ void Board::PlaceMines(int safeX, int safeY) {
     if (std::abs(x - safeX) <= 1 && std::abs(y - safeY) <= 1)
       continue;
 
-    if (!grid[y][x].isMine) {
-      grid[y][x].isMine = true;
+    if (!At(x, y).isMine) {
+      At(x, y).isMine = true;
       minesPlaced++;
     }
   }
 }
 
 void Board::GenerateNoGuess(int startX, int startY) {
-  for (int y = 0; y < height; y++) {
-    for (int x = 0; x < width; x++) {
-      grid[y][x].isMine = false;
-      grid[y][x].isFlagged = false;
-      grid[y][x].isRevealed = false;
-      grid[y][x].neighborMines = 0;
+  TRACE_SCOPE("Board::GenerateNoGuess");
+  // The first reveal and any flags are undone along with the mines.
+  if (changeLog != nullptr) {
+    for (int i = 0; i < width * height; i++) {
+      if (cells[i].isRevealed || cells[i].isFlagged)
+        changeLog->push_back(i);
     }
   }
-  firstClick = false;
+  std::uninitialized_fill_n(cells, width * height, Cell());
+  header->firstClick = false;
 
   PlaceMines(startX, startY);
   CalculateNumbers();
 
-  grid[startY][startX].isRevealed = true;
-  if (grid[startY][startX].neighborMines == 0) {
-    FloodFill(startX, startY);
-  }
+  std::mt19937 rng(header->seed ^ 0x9e3779b9u);
+  std::uniform_int_distribution<int> distX(0, width - 1);
+  std::uniform_int_distribution<int> distY(0, height - 1);
 
   int attempts = 0;
-  while (!IsSolvable(startX, startY) && attempts < 1000) {
+  while (true) {
+    TRACE_SCOPE_ARG("GenerateNoGuess attempt", "attempt", attempts);
+    if (IsSolvable(startX, startY) || attempts >= 1000)
+      break;
     attempts++;
 
-    std::mt19937 rng(static_cast<unsigned int>(std::time(nullptr)) + attempts);
-    std::uniform_int_distribution<int> distX(0, width - 1);
-    std::uniform_int_distribution<int> distY(0, height - 1);
-
     int mX, mY;
     do {
       mX = distX(rng);
       mY = distY(rng);
-    } while (!grid[mY][mX].isMine);
+    } while (!At(mX, mY).isMine);
 
-    grid[mY][mX].isMine = false;
+    At(mX, mY).isMine = false;
 
     int nX, nY;
     do {
       nX = distX(rng);
       nY = distY(rng);
-    } while (grid[nY][nX].isMine ||
+    } while (At(nX, nY).isMine ||
              (std::abs(nX - startX) <= 1 && std::abs(nY - startY) <= 1));
 
-    grid[nY][nX].isMine = true;
+    At(nX, nY).isMine = true;
 
     CalculateNumbers();
   }
@@ -194,18 +334,16 @@ void Board::GenerateNoGuess(int startX, int startY) {
     CalculateNumbers();
   }
 
-  grid[startY][startX].isRevealed = false;
-  if (grid[startY][startX].neighborMines == 0) {
-    FloodFill(startX, startY);
-  } else {
-    grid[startY][startX].isRevealed = true;
-  }
+  RebuildTiles();
+  LabelOpenings();
+  FloodFill(startX, startY);
 }
 
 void Board::CalculateNumbers() {
+  TRACE_SCOPE("Board::CalculateNumbers");
   for (int y = 0; y < height; y++) {
     for (int x = 0; x < width; x++) {
-      if (grid[y][x].isMine)
+      if (At(x, y).isMine)
         continue;
 
       int mines = 0;
@@ -215,58 +353,239 @@ void Board::CalculateNumbers() {
             continue;
           int nx = x + dx;
           int ny = y + dy;
-          if (IsValid(nx, ny) && grid[ny][nx].isMine) {
+          if (IsValid(nx, ny) && At(nx, ny).isMine) {
             mines++;
           }
         }
       }
-      grid[y][x].neighborMines = mines;
+      At(x, y).neighborMines = mines;
     }
   }
 }
 
 void Board::RevealAllMines() {
-  for (auto &row : grid) {
-    for (auto &cell : row) {
-      if (cell.isMine) {
-        cell.isRevealed = true;
+  for (int ty = 0; ty < tilesY; ty++) {
+    for (int tx = 0; tx < tilesX; tx++) {
+      if (tiles[ty * tilesX + tx].mines == 0)
+        continue;
+      int endX = std::min((tx + 1) * tileSize, width);
+      int endY = std::min((ty + 1) * tileSize, height);
+      for (int y = ty * tileSize; y < endY; y++) {
+        for (int x = tx * tileSize; x < endX; x++) {
+          if (At(x, y).isMine)
+            SetRevealed(x, y);
+        }
       }
     }
   }
 }
 
 void Board::CheckWinCondition() {
-  int revealedCount = 0;
-  for (const auto &row : grid) {
-    for (const auto &cell : row) {
-      if (cell.isRevealed)
-        revealedCount++;
+  if (header->revealedCount != width * height - totalMines)
+    return;
+
+  header->gameWon = true;
+  header->gameOver = true;
+  for (int ty = 0; ty < tilesY; ty++) {
+    for (int tx = 0; tx < tilesX; tx++) {
+      if (tiles[ty * tilesX + tx].mines == 0)
+        continue;
+      int endX = std::min((tx + 1) * tileSize, width);
+      int endY = std::min((ty + 1) * tileSize, height);
+      for (int y = ty * tileSize; y < endY; y++) {
+        for (int x = tx * tileSize; x < endX; x++) {
+          if (At(x, y).isMine)
+            SetFlagged(x, y, true);
+        }
+      }
+    }
+  }
+}
+
+int Board::GetMinesLeft() const { return totalMines - header->flagCount; }
+
+int Board::CountFlaggedMines() const {
+  int count = 0;
+  for (int ty = 0; ty < tilesY; ty++) {
+    for (int tx = 0; tx < tilesX; tx++) {
+      const Tile &tile = GetTile(tx, ty);
+      if (tile.flagged == 0 || tile.mines == 0)
+        continue;
+      int endX = std::min((tx + 1) * tileSize, width);
+      int endY = std::min((ty + 1) * tileSize, height);
+      for (int y = ty * tileSize; y < endY; y++) {
+        for (int x = tx * tileSize; x < endX; x++) {
+          const Cell &cell = cells[y * width + x];
+          if (cell.isMine && cell.isFlagged)
+            count++;
+        }
+      }
     }
   }
+  return count;
+}
+
+void Board::LabelOpenings() {
+  TRACE_SCOPE("Board::LabelOpenings");
+  // Walks a parent chain to its root, halving the path on the way.
+  auto find = [this](int i) {
+    while (openingOf[i] != i)
+      i = openingOf[i] = openingOf[openingOf[i]];
+    return i;
+  };
 
-  if (revealedCount == (width * height - totalMines)) {
-    gameWon = true;
-    gameOver = true;
-    for (auto &row : grid) {
-      for (auto &cell : row) {
-        if (cell.isMine)
-          cell.isFlagged = true;
+  // One raster pass links each empty cell to an empty neighbour already
+  // visited. W, NW and NE all touch N, so N alone settles it when empty;
+  // otherwise NE may join W or NW, the one union needed. Parents always
+  // precede their children. Mines and numbers are scattered at random, so
+  // the choices are made with selects rather than branches.
+  for (int y = 0; y < height; y++) {
+    int row = y * width;
+    for (int x = 0; x < width; x++) {
+      int i = row + x;
+      bool empty = !cells[i].isMine & (cells[i].neighborMines == 0);
+      bool hasW = x > 0 && openingOf[i - 1] >= 0;
+      bool hasN = false, hasNW = false, hasNE = false;
+      if (y > 0) {
+        hasN = openingOf[i - width] >= 0;
+        hasNW = x > 0 && openingOf[i - width - 1] >= 0;
+        hasNE = x + 1 < width && openingOf[i - width + 1] >= 0;
+      }
+      int parent = hasW ? i - 1 : i;
+      parent = hasNW ? i - width - 1 : parent;
+      parent = hasNE ? i - width + 1 : parent;
+      parent = hasN ? i - width : parent;
+      openingOf[i] = empty ? parent : noOpening;
+      if (empty && hasNE && !hasN && (hasW || hasNW)) {
+        int a = find(i - width + 1);
+        int b = find(hasW ? i - 1 : i - width - 1);
+        if (a != b)
+          openingOf[std::max(a, b)] = std::min(a, b);
       }
     }
   }
+
+  // Marks cells with an empty cell in their row span x-1..x+1, using the
+  // solved flags as scratch until they are cleared below.
+  unsigned char *nearEmpty = openingSolved.data();
+  for (int y = 0; y < height; y++) {
+    const int *row = openingOf.data() + y * width;
+    unsigned char *out = nearEmpty + y * width;
+    for (int x = 0; x < width; x++) {
+      bool left = x > 0 && row[x - 1] >= 0;
+      bool right = x + 1 < width && row[x + 1] >= 0;
+      out[x] = left | (row[x] >= 0) | right;
+    }
+  }
+
+  // A second pass in the same order finds every parent already resolved to
+  // its root, so each empty cell settles in one step. Numbers with no empty
+  // neighbour each add a click, as does each opening's root.
+  bbbv = 0;
+  for (int y = 0; y < height; y++) {
+    // Edge rows stand in for the missing row beyond them.
+    const unsigned char *above = nearEmpty + std::max(y - 1, 0) * width;
+    const unsigned char *below =
+        nearEmpty + std::min(y + 1, height - 1) * width;
+    for (int x = 0; x < width; x++) {
+      int i = y * width + x;
+      int label = openingOf[i];
+      bool empty = label >= 0;
+      int root = openingOf[empty ? label : i];
+      bool border = above[x] | nearEmpty[i] | below[x];
+      bool isolated = !empty & !cells[i].isMine & !border;
+      openingOf[i] = empty ? root : isolated ? isolatedNumber : noOpening;
+      bbbv += (empty & (root == i)) | isolated;
+    }
+  }
+  std::fill(openingSolved.begin(), openingSolved.end(), 0);
+  solvedBBBV = 0;
 }
 
-int Board::GetMinesLeft() const {
-  int flags = 0;
-  for (const auto &row : grid) {
-    for (const auto &cell : row) {
-      if (cell.isFlagged)
-        flags++;
+void Board::RestoreOpenings() {
+  if (header->firstClick) {
+    bbbv = 0;
+    solvedBBBV = 0;
+    return;
+  }
+  LabelOpenings();
+  for (int i = 0; i < width * height; i++) {
+    int opening = openingOf[i];
+    if (!cells[i].isRevealed || opening == noOpening)
+      continue;
+    if (opening == isolatedNumber) {
+      solvedBBBV++;
+    } else if (!openingSolved[opening]) {
+      openingSolved[opening] = 1;
+      solvedBBBV++;
     }
   }
-  return totalMines - flags;
 }
+
+void Board::SetRevealed(int x, int y) {
+  Cell &cell = At(x, y);
+  if (cell.isRevealed)
+    return;
+  cell.isRevealed = true;
+  Tile &tile = TileAt(x, y);
+  tile.revealed++;
+  tile.version++;
+  header->revealedCount++;
+  if (changeLog != nullptr)
+    changeLog->push_back(y * width + x);
+
+  int opening = openingOf[y * width + x];
+  if (opening == isolatedNumber) {
+    solvedBBBV++;
+  } else if (opening >= 0 && !openingSolved[opening]) {
+    openingSolved[opening] = 1;
+    solvedBBBV++;
+  }
+}
+
+void Board::SetFlagged(int x, int y, bool flagged) {
+  Cell &cell = At(x, y);
+  if (cell.isFlagged == flagged)
+    return;
+  cell.isFlagged = flagged;
+  Tile &tile = TileAt(x, y);
+  tile.flagged += flagged ? 1 : -1;
+  tile.version++;
+  header->flagCount += flagged ? 1 : -1;
+  if (changeLog != nullptr)
+    changeLog->push_back(y * width + x);
+}
+
+void Board::RebuildTiles() {
+  for (int i = 0; i < tilesX * tilesY; i++) {
+    unsigned int version = tiles[i].version + 1;
+    tiles[i] = Tile();
+    tiles[i].version = version;
+  }
+
+  header->revealedCount = 0;
+  header->flagCount = 0;
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      const Cell &cell = At(x, y);
+      Tile &tile = TileAt(x, y);
+      tile.cells++;
+      if (cell.isRevealed) {
+        tile.revealed++;
+        header->revealedCount++;
+      }
+      if (cell.isFlagged) {
+        tile.flagged++;
+        header->flagCount++;
+      }
+      if (cell.isMine)
+        tile.mines++;
+    }
+  }
+}
+
 bool Board::IsSolvable(int startX, int startY) {
+  TRACE_SCOPE("Board::IsSolvable");
   struct SolverCell {
     bool revealed = false;
     bool flagged = false;
@@ -274,29 +593,99 @@ bool Board::IsSolvable(int startX, int startY) {
   std::vector<std::vector<SolverCell>> solverGrid(
       height, std::vector<SolverCell>(width));
 
-  auto simulateReveal = [&](auto self, int x, int y) -> void {
-    if (!IsValid(x, y) || solverGrid[y][x].revealed)
+  // Unknown cells per tile. A cell's neighbours all lie in its own tile or an
+  // adjacent one, so a tile whose 3x3 tile neighbourhood has no unknowns left
+  // cannot produce new deductions and is skipped by the sweeps below.
+  std::vector<int> tileUnknown(tilesX * tilesY, 0);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      tileUnknown[(y / tileSize) * tilesX + x / tileSize]++;
+    }
+  }
+  int solverRevealed = 0;
+  int solverFlags = 0;
+
+  auto isSettled = [&](int tx, int ty) {
+    for (int dy = -1; dy <= 1; dy++) {
+      for (int dx = -1; dx <= 1; dx++) {
+        int nx = tx + dx, ny = ty + dy;
+        if (nx >= 0 && nx < tilesX && ny >= 0 && ny < tilesY &&
+            tileUnknown[ny * tilesX + nx] > 0)
+          return false;
+      }
+    }
+    return true;
+  };
+
+  auto forEachActiveCell = [&](auto &&fn) {
+    for (int ty = 0; ty < tilesY; ty++) {
+      for (int tx = 0; tx < tilesX; tx++) {
+        if (isSettled(tx, ty))
+          continue;
+        int endX = std::min((tx + 1) * tileSize, width);
+        int endY = std::min((ty + 1) * tileSize, height);
+        for (int y = ty * tileSize; y < endY; y++) {
+          for (int x = tx * tileSize; x < endX; x++) {
+            fn(x, y);
+          }
+        }
+      }
+    }
+  };
+
+  auto markFlagged = [&](int x, int y) {
+    SolverCell &sc = solverGrid[y][x];
+    if (sc.flagged)
+      return;
+    sc.flagged = true;
+    solverFlags++;
+    if (!sc.revealed)
+      tileUnknown[(y / tileSize) * tilesX + x / tileSize]--;
+  };
+
+  // Uses floodStack like FloodFill, for the same reason: an opening can be
+  // far larger than the call stack allows recursing over.
+  auto visit = [&](int x, int y) {
+    SolverCell &sc = solverGrid[y][x];
+    if (sc.revealed)
       return;
-    solverGrid[y][x].revealed = true;
-    if (grid[y][x].neighborMines == 0) {
+    sc.revealed = true;
+    solverRevealed++;
+    if (!sc.flagged)
+      tileUnknown[(y / tileSize) * tilesX + x / tileSize]--;
+    if (At(x, y).neighborMines == 0)
+      floodStack.push_back(y * width + x);
+  };
+
+  auto simulateReveal = [&](int x, int y) {
+    floodStack.clear();
+    visit(x, y);
+    while (!floodStack.empty()) {
+      int index = floodStack.back();
+      floodStack.pop_back();
+      int cx = index % width;
+      int cy = index / width;
       for (int dy = -1; dy <= 1; dy++) {
         for (int dx = -1; dx <= 1; dx++) {
-          if (dx != 0 || dy != 0)
-            self(self, x + dx, y + dy);
+          if ((dx != 0 || dy != 0) && IsValid(cx + dx, cy + dy))
+            visit(cx + dx, cy + dy);
         }
       }
     }
   };
 
-  simulateReveal(simulateReveal, startX, startY);
+  simulateReveal(startX, startY);
 
   bool changed = true;
+  int pass = 0;
   while (changed) {
     changed = false;
+    pass++;
 
-    for (int y = 0; y < height; y++) {
-      for (int x = 0; x < width; x++) {
-        if (solverGrid[y][x].revealed && grid[y][x].neighborMines > 0) {
+    {
+      TRACE_SCOPE_ARG("IsSolvable single-cell", "pass", pass);
+      forEachActiveCell([&](int x, int y) {
+        if (solverGrid[y][x].revealed && At(x, y).neighborMines > 0) {
           int unrevealed = 0;
           int flags = 0;
           std::vector<std::pair<int, int>> unrevealedCells;
@@ -316,29 +705,30 @@ bool Board::IsSolvable(int startX, int startY) {
             }
           }
 
-          if (flags == grid[y][x].neighborMines && unrevealed > 0) {
+          if (flags == At(x, y).neighborMines && unrevealed > 0) {
             for (auto p : unrevealedCells) {
-              simulateReveal(simulateReveal, p.first, p.second);
+              simulateReveal(p.first, p.second);
               changed = true;
             }
-          } else if (unrevealed + flags == grid[y][x].neighborMines &&
+          } else if (unrevealed + flags == At(x, y).neighborMines &&
                      unrevealed > 0) {
             for (auto p : unrevealedCells) {
-              solverGrid[p.second][p.first].flagged = true;
+              markFlagged(p.first, p.second);
               changed = true;
             }
           }
         }
-      }
+      });
     }
 
     if (changed)
       continue;
 
-    for (int y1 = 0; y1 < height; y1++) {
-      for (int x1 = 0; x1 < width; x1++) {
-        if (!solverGrid[y1][x1].revealed || grid[y1][x1].neighborMines == 0)
-          continue;
+    {
+      TRACE_SCOPE_ARG("IsSolvable subset", "pass", pass);
+      forEachActiveCell([&](int x1, int y1) {
+        if (!solverGrid[y1][x1].revealed || At(x1, y1).neighborMines == 0)
+          return;
 
         std::vector<std::pair<int, int>> neighborsA;
         int flagsA = 0;
@@ -355,8 +745,8 @@ bool Board::IsSolvable(int startX, int startY) {
         }
 
         if (neighborsA.empty())
-          continue;
-        int minesNeededA = grid[y1][x1].neighborMines - flagsA;
+          return;
+        int minesNeededA = At(x1, y1).neighborMines - flagsA;
 
         for (int dy = -2; dy <= 2; dy++) {
           for (int dx = -2; dx <= 2; dx++) {
@@ -364,7 +754,7 @@ bool Board::IsSolvable(int startX, int startY) {
 
             if (!IsValid(x2, y2) || (x1 == x2 && y1 == y2))
               continue;
-            if (!solverGrid[y2][x2].revealed || grid[y2][x2].neighborMines == 0)
+            if (!solverGrid[y2][x2].revealed || At(x2, y2).neighborMines == 0)
               continue;
 
             std::vector<std::pair<int, int>> neighborsB;
@@ -383,7 +773,7 @@ bool Board::IsSolvable(int startX, int startY) {
 
             if (neighborsB.empty())
               continue;
-            int minesNeededB = grid[y2][x2].neighborMines - flagsB;
+            int minesNeededB = At(x2, y2).neighborMines - flagsB;
 
             bool isSubset = true;
             for (auto &pA : neighborsA) {
@@ -422,14 +812,14 @@ bool Board::IsSolvable(int startX, int startY) {
               if (minesInDiff == 0) {
                 for (auto &p : diff) {
                   if (!solverGrid[p.second][p.first].revealed) {
-                    simulateReveal(simulateReveal, p.first, p.second);
+                    simulateReveal(p.first, p.second);
                     changed = true;
                   }
                 }
-              } else if (minesInDiff == diff.size()) {
+              } else if (minesInDiff == (int)diff.size()) {
                 for (auto &p : diff) {
                   if (!solverGrid[p.second][p.first].flagged) {
-                    solverGrid[p.second][p.first].flagged = true;
+                    markFlagged(p.first, p.second);
                     changed = true;
                   }
                 }
@@ -437,51 +827,51 @@ bool Board::IsSolvable(int startX, int startY) {
             }
           }
         }
-      }
+      });
     }
 
     if (changed)
       continue;
 
-    int totalRevealedAndFlagged = 0;
-    int currentFlags = 0;
-    std::vector<std::pair<int, int>> unknownCells;
+    TRACE_SCOPE_ARG("IsSolvable global count", "pass", pass);
+    int unknownCount = width * height - solverRevealed - solverFlags;
+    int minesLeft = totalMines - solverFlags;
+    if (unknownCount == 0 || (minesLeft != unknownCount && minesLeft != 0))
+      continue;
 
-    for (int y = 0; y < height; y++) {
-      for (int x = 0; x < width; x++) {
-        if (solverGrid[y][x].revealed || solverGrid[y][x].flagged)
-          totalRevealedAndFlagged++;
-        if (solverGrid[y][x].flagged)
-          currentFlags++;
-        if (!solverGrid[y][x].revealed && !solverGrid[y][x].flagged)
-          unknownCells.push_back({x, y});
+    std::vector<std::pair<int, int>> unknownCells;
+    for (int ty = 0; ty < tilesY; ty++) {
+      for (int tx = 0; tx < tilesX; tx++) {
+        if (tileUnknown[ty * tilesX + tx] == 0)
+          continue;
+        int endX = std::min((tx + 1) * tileSize, width);
+        int endY = std::min((ty + 1) * tileSize, height);
+        for (int y = ty * tileSize; y < endY; y++) {
+          for (int x = tx * tileSize; x < endX; x++) {
+            if (!solverGrid[y][x].revealed && !solverGrid[y][x].flagged)
+              unknownCells.push_back({x, y});
+          }
+        }
       }
     }
 
-    int minesLeft = totalMines - currentFlags;
-    if (minesLeft == unknownCells.size() && minesLeft > 0) {
+    if (minesLeft == unknownCount && minesLeft > 0) {
       for (auto &p : unknownCells) {
-        solverGrid[p.second][p.first].flagged = true;
+        markFlagged(p.first, p.second);
         changed = true;
       }
-    } else if (minesLeft == 0 && !unknownCells.empty()) {
+    } else if (minesLeft == 0) {
       for (auto &p : unknownCells) {
-        simulateReveal(simulateReveal, p.first, p.second);
+        simulateReveal(p.first, p.second);
         changed = true;
       }
     }
   }
 
-  for (int y = 0; y < height; y++) {
-    for (int x = 0; x < width; x++) {
-      if (!grid[y][x].isMine && !solverGrid[y][x].revealed)
-        return false;
-    }
-  }
-  return true;
+  return solverRevealed == width * height - totalMines;
 }
 
 void Board::TriggerLose() {
-  gameOver = true;
+  header->gameOver = true;
   RevealAllMines();
 }
@@ -1,12 +1,48 @@
 #pragma once
 #include "Cell.h"
+#include "MappedFile.h"
+#include "Tile.h"
+#include <cstdint>
+#include <string>
 #include <vector>
 
+// Fixed binary layout at the start of the board storage block, followed by
+// the tile summaries and then the cells in row-major order. The same layout
+// is used in memory and in a mapped board file.
+struct BoardHeader {
+  char magic[4];
+  uint32_t version;
+  int32_t width;
+  int32_t height;
+  int32_t totalMines;
+  int32_t clickedMineX;
+  int32_t clickedMineY;
+  int32_t revealedCount;
+  int32_t flagCount;
+  float elapsedTime; // Owned by Game, stored here so a resume restores it
+  uint8_t firstClick;
+  uint8_t gameOver;
+  uint8_t gameWon;
+  uint8_t reserved0;
+  uint32_t seed; // Drives mine placement, so a seed plus moves replays a game
+  uint8_t reserved[16];
+};
+static_assert(sizeof(BoardHeader) == 64, "BoardHeader layout changed");
+
 class Board {
 public:
+  // Largest side accepted from the command line, bots and replays; keeps
+  // width * height and the cell array in range.
+  static constexpr int maxSide = 8192;
+
   Board(int width, int height, int mines);
+  Board(const Board &) = delete;
+  Board &operator=(const Board &) = delete;
 
   void Reset();
+  // Starts a fresh board of a new size, kept in the same storage file if
+  // one is open.
+  void Resize(int width, int height, int mines);
   void Reveal(int x, int y);
   void ToggleFlag(int x, int y);
   void Chord(int x, int y);
@@ -14,34 +50,104 @@ public:
 
   int GetWidth() const { return width; }
   int GetHeight() const { return height; }
+  int GetTotalMines() const { return totalMines; }
   const Cell &GetCell(int x, int y) const;
-  bool IsGameOver() const { return gameOver; }
-  bool IsGameWon() const { return gameWon; }
+  bool IsGameOver() const { return header->gameOver; }
+  bool IsGameWon() const { return header->gameWon; }
   int GetMinesLeft() const;
-  bool IsFirstClick() const { return firstClick; }
+  int GetRevealedCount() const { return header->revealedCount; }
+  // Flags placed on actual mines, counted over tiles holding both.
+  int CountFlaggedMines() const;
+  // 3BV: the fewest clicks that clear the board, one per opening plus one
+  // per safe cell not bordering an opening. 0 until the mines are placed.
+  int Get3BV() const { return bbbv; }
+  // The part of the 3BV cleared so far: openings opened and isolated numbers
+  // revealed. Kept up to date by each reveal.
+  int GetSolved3BV() const { return solvedBBBV; }
+  bool IsFirstClick() const { return header->firstClick; }
   void GetClickedMine(int &x, int &y) const {
-    x = clickedMineX;
-    y = clickedMineY;
+    x = header->clickedMineX;
+    y = header->clickedMineY;
   }
   bool IsSolvable(int startX, int startY);
   void TriggerLose();
   void GenerateNoGuess(int startX, int startY);
 
+  static constexpr int tileSize = 8;
+  int GetTilesX() const { return tilesX; }
+  int GetTilesY() const { return tilesY; }
+  const Tile &GetTile(int tx, int ty) const { return tiles[ty * tilesX + tx]; }
+
+  // Moves the board into a memory-mapped file at `path`. If the file holds a
+  // board of the same size it is resumed in place, otherwise it starts fresh.
+  // Returns true when a saved board was resumed.
+  bool OpenStorage(const std::string &path);
+  // Flushes a mapped board to disk. Call at safe points, not every frame.
+  void Sync();
+  bool IsMapped() const { return mapped.IsOpen(); }
+  float GetElapsedTime() const { return header->elapsedTime; }
+  void SetElapsedTime(float time) { header->elapsedTime = time; }
+
+  uint32_t GetSeed() const { return header->seed; }
+  // Only affects boards whose mines have not been placed yet.
+  void SetSeed(uint32_t seed) { header->seed = seed; }
+
+  // While set, the index of every cell whose revealed or flagged state
+  // changes is appended to `log`, possibly more than once. Reset, Resize and
+  // UnpackState rewrite the whole board and are not logged.
+  void SetChangeLog(std::vector<int> *log) { changeLog = log; }
+
+  // One byte per cell plus the game flags, used for replay keyframes.
+  size_t PackedStateSize() const;
+  void PackState(unsigned char *out) const;
+  void UnpackState(const unsigned char *in);
+
 private:
   int width;
   int height;
   int totalMines;
-  std::vector<std::vector<Cell>> grid;
-  bool firstClick;
-  bool gameOver;
-  bool gameWon;
+  int tilesX = 0;
+  int tilesY = 0;
+
+  BoardHeader *header = nullptr;
+  Tile *tiles = nullptr;
+  Cell *cells = nullptr;
+  std::vector<unsigned char> heapStorage;
+  MappedFile mapped;
+  std::string storagePath;
+  std::vector<int> floodStack;
+  std::vector<int> *changeLog = nullptr;
 
-  int clickedMineX = -1;
-  int clickedMineY = -1;
+  // 3BV state, derived from the mines and so kept out of the stored layout.
+  // openingOf holds an empty cell's opening as the index of its first cell,
+  // or one of the negative markers below for every other cell.
+  static constexpr int noOpening = -1;     // mines, numbers beside an opening
+  static constexpr int isolatedNumber = -2; // numbers that cost a click each
+  std::vector<int> openingOf;
+  std::vector<unsigned char> openingSolved; // by an opening's first cell
+  int bbbv = 0;
+  int solvedBBBV = 0;
+
+  Cell &At(int x, int y) { return cells[y * width + x]; }
+  size_t StorageSize() const;
+  void BindStorage(unsigned char *base);
+  void InitStorage();
+  bool IsStoredBoardValid(const unsigned char *base) const;
 
   void PlaceMines(int safeX, int safeY);
   void CalculateNumbers();
   void FloodFill(int x, int y);
   void CheckWinCondition();
   void RevealAllMines();
+
+  Tile &TileAt(int x, int y) {
+    return tiles[(y / tileSize) * tilesX + x / tileSize];
+  }
+  void SetRevealed(int x, int y);
+  void LabelOpenings();
+  // For boards loaded whole rather than played up to: relabels and counts
+  // what is already revealed.
+  void RestoreOpenings();
+  void SetFlagged(int x, int y, bool flagged);
+  void RebuildTiles();
 };
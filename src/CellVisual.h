@@ -0,0 +1,15 @@
+#pragma once
+
+// What a cell currently looks like. Renderers key cached sprites and dirty
+// checks on this rather than on the raw Cell flags.
+enum CellVisual : unsigned char {
+  VISUAL_HIDDEN = 0,
+  VISUAL_HIDDEN_FLAGGED,
+  VISUAL_EMPTY,
+  VISUAL_NUMBER_1, // VISUAL_NUMBER_1 + n - 1 for n in 1..8
+  VISUAL_MINE = VISUAL_NUMBER_1 + 8,
+  VISUAL_MINE_EXPLODED,
+  VISUAL_MINE_FLAGGED,
+  VISUAL_COUNT,
+  VISUAL_NONE = 0xff
+};
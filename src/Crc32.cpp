@@ -0,0 +1,27 @@
+#include "Crc32.h"
+
+namespace {
+
+struct Crc32Table {
+  uint32_t entries[256];
+
+  Crc32Table() {
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t c = i;
+      for (int bit = 0; bit < 8; bit++)
+        c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      entries[i] = c;
+    }
+  }
+};
+
+} // namespace
+
+uint32_t Crc32(const void *data, size_t size, uint32_t crc) {
+  static const Crc32Table table;
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  crc = ~crc;
+  for (size_t i = 0; i < size; i++)
+    crc = table.entries[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+  return ~crc;
+}
@@ -0,0 +1,7 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// CRC-32 (IEEE 802.3, as used by zlib and PNG). Pass a previous result as
+// `crc` to continue a checksum across several buffers.
+uint32_t Crc32(const void *data, size_t size, uint32_t crc = 0);
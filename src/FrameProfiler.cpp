@@ -0,0 +1,101 @@
+#include "FrameProfiler.h"
+#include "raylib.h"
+#include <algorithm>
+#include <cstdio>
+
+static const char *phaseNames[PHASE_COUNT] = {"input", "update", "draw",
+                                              "present"};
+static const Color phaseColors[PHASE_COUNT] = {SKYBLUE, GREEN, ORANGE, GRAY};
+
+void FrameProfiler::Begin(ProfilePhase phase) { starts[phase] = Clock::now(); }
+
+void FrameProfiler::End(ProfilePhase phase) {
+  current[phase] +=
+      std::chrono::duration<float, std::milli>(Clock::now() - starts[phase])
+          .count();
+}
+
+void FrameProfiler::EndFrame() {
+  std::copy(current, current + PHASE_COUNT, samples[head]);
+  std::fill(current, current + PHASE_COUNT, 0.0f);
+  head = (head + 1) % capacity;
+  count = std::min(count + 1, capacity);
+}
+
+const float *FrameProfiler::Sample(int age) const {
+  return samples[(head - 1 - age + capacity) % capacity];
+}
+
+FrameProfiler::Summary FrameProfiler::Summarize(ProfilePhase phase) const {
+  if (count == 0)
+    return {0, 0, 0, 0};
+  for (int i = 0; i < count; i++)
+    scratch[i] = Sample(i)[phase];
+
+  Summary summary;
+  auto minMax = std::minmax_element(scratch, scratch + count);
+  summary.min = *minMax.first;
+  summary.max = *minMax.second;
+  std::nth_element(scratch, scratch + count / 2, scratch + count);
+  summary.median = scratch[count / 2];
+  std::nth_element(scratch, scratch + count * 99 / 100, scratch + count);
+  summary.p99 = scratch[count * 99 / 100];
+  return summary;
+}
+
+void FrameProfiler::Draw(int x, int y) const {
+  const int graphHeight = 80;
+  const float fullScaleMs = 1000.0f / 30.0f;
+  int width = capacity + 20;
+  int height = graphHeight + 30 + PHASE_COUNT * 14;
+
+  DrawRectangle(x, y, width, height, Color{0, 0, 0, 190});
+  DrawText("FRAME TIME (P: hide, F3: export)", x + 10, y + 6, 10, RAYWHITE);
+
+  // Newest frame on the right, phases stacked bottom-up.
+  int graphX = x + 10;
+  int graphBottom = y + 20 + graphHeight;
+  for (int age = 0; age < count; age++) {
+    const float *sample = Sample(age);
+    int barX = graphX + capacity - 1 - age;
+    float stacked = 0.0f;
+    for (int p = 0; p < PHASE_COUNT; p++) {
+      int bottom = (int)(stacked / fullScaleMs * graphHeight);
+      stacked += sample[p];
+      int top = std::min((int)(stacked / fullScaleMs * graphHeight),
+                         graphHeight);
+      if (top > bottom)
+        DrawRectangle(barX, graphBottom - top, 1, top - bottom,
+                      phaseColors[p]);
+    }
+  }
+  int targetY = graphBottom - (int)(16.67f / fullScaleMs * graphHeight);
+  DrawLine(graphX, targetY, graphX + capacity, targetY, Color{255, 0, 0, 160});
+
+  int textY = graphBottom + 6;
+  for (int p = 0; p < PHASE_COUNT; p++) {
+    Summary s = Summarize((ProfilePhase)p);
+    DrawText(TextFormat("%-8s min %5.2f  med %5.2f  p99 %5.2f  max %5.2f",
+                        phaseNames[p], s.min, s.median, s.p99, s.max),
+             x + 10, textY, 10, phaseColors[p]);
+    textY += 14;
+  }
+}
+
+bool FrameProfiler::ExportCsv(const std::string &path) const {
+  FILE *file = std::fopen(path.c_str(), "w");
+  if (file == nullptr)
+    return false;
+  std::fprintf(file, "frame");
+  for (const char *name : phaseNames)
+    std::fprintf(file, ",%s_ms", name);
+  std::fprintf(file, "\n");
+  for (int age = count - 1; age >= 0; age--) {
+    const float *sample = Sample(age);
+    std::fprintf(file, "%d", count - 1 - age);
+    for (int p = 0; p < PHASE_COUNT; p++)
+      std::fprintf(file, ",%.4f", sample[p]);
+    std::fprintf(file, "\n");
+  }
+  return std::fclose(file) == 0;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <chrono>
+#include <string>
+
+enum ProfilePhase {
+  PHASE_INPUT = 0, // Game::HandleInput
+  PHASE_UPDATE,    // The rest of Game::Update
+  PHASE_DRAW,      // UI::Draw
+  PHASE_PRESENT,   // EndDrawing: buffer swap, frame limiter, event polling
+  PHASE_COUNT
+};
+
+// Per-phase frame times for the last `capacity` frames in a fixed ring
+// buffer, drawn as a stacked graph with min/median/p99/max per phase.
+class FrameProfiler {
+public:
+  static constexpr int capacity = 240;
+
+  void Begin(ProfilePhase phase);
+  void End(ProfilePhase phase);
+  // Commits the phases timed since the last call as one frame.
+  void EndFrame();
+
+  void Draw(int x, int y) const;
+  // Writes the buffered frames, oldest first, as CSV.
+  bool ExportCsv(const std::string &path) const;
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Summary {
+    float min, median, p99, max;
+  };
+
+  float samples[capacity][PHASE_COUNT] = {};
+  float current[PHASE_COUNT] = {};
+  Clock::time_point starts[PHASE_COUNT];
+  int head = 0; // Slot the next frame is written to
+  int count = 0;
+  mutable float scratch[capacity];
+
+  const float *Sample(int age) const; // age 0 is the newest frame
+  Summary Summarize(ProfilePhase phase) const;
+};
+
+// Times `phase` for the lifetime of the scope.
+class ProfileScope {
+public:
+  ProfileScope(FrameProfiler &profiler, ProfilePhase phase)
+      : profiler(profiler), phase(phase) {
+    profiler.Begin(phase);
+  }
+  ~ProfileScope() { profiler.End(phase); }
+  ProfileScope(const ProfileScope &) = delete;
+  ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+  FrameProfiler &profiler;
+  ProfilePhase phase;
+};
@@ -1,40 +1,254 @@
 
 
 #include "Game.h"
+#include "AllocTracker.h"
+#include "Assets.h"
+#include "Trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
 #if defined(PLATFORM_WEB)
 #include <emscripten/emscripten.h>
+#include <emscripten/html5.h>
 #endif
 
-Game::Game()
-    : screenWidth(800), screenHeight(600), board(30, 16, 99),
-      statManager("stats.dat"), ui(board, statManager),
+#if defined(PLATFORM_WEB)
+// The browser has no blocking event wait, so an idle page pauses its main
+// loop and any input event resumes it.
+static bool mainLoopPaused = false;
+
+template <typename Event>
+static EM_BOOL WakeMainLoop(int, const Event *, void *) {
+  if (mainLoopPaused) {
+    mainLoopPaused = false;
+    emscripten_resume_main_loop();
+  }
+  return EM_FALSE;
+}
+#endif
+
+// Taken during static initialization, as close to process start as the
+// program itself can measure.
+static const std::chrono::steady_clock::time_point processStart =
+    std::chrono::steady_clock::now();
+
+static float MsSinceStart() {
+  return std::chrono::duration<float, std::milli>(
+             std::chrono::steady_clock::now() - processStart)
+      .count();
+}
+
+// Selected with the 1-3 keys; any other size comes from --size and --mines.
+struct Difficulty {
+  int width;
+  int height;
+  int mines;
+};
+static const Difficulty difficulties[] = {
+    {9, 9, 10},   // Beginner
+    {16, 16, 40}, // Intermediate
+    {30, 16, 99}, // Expert
+};
+
+static std::unique_ptr<InputSource> CreateInput(const GameOptions &options) {
+  if (!options.traceFile.empty()) {
+    auto trace = std::make_unique<TraceInput>();
+    if (!trace->Load(options.traceFile)) {
+      TraceLog(LOG_WARNING, "TRACE: Could not load %s",
+               options.traceFile.c_str());
+    }
+    return trace;
+  }
+  return std::make_unique<RaylibInput>(options.recordTraceFile);
+}
+
+Game::Game(const GameOptions &options)
+    : screenWidth(800), screenHeight(600),
+      board(options.boardWidth, options.boardHeight, options.boardMines),
+      input(CreateInput(options)), headless(!options.traceFile.empty()),
+      assertNoAlloc(options.assertNoAlloc),
+      statManager(headless ? "" : "stats.dat"), ui(board, statManager, *input),
       state(GameState::PLAYING) {
-  int cellS = 32;
-  int boardW = 30 * cellS;
-  int boardH = 16 * cellS;
+  UpdateWindowSize();
+
+  // Allocation tracking builds report allocating frames at debug level.
+  if (AllocTracker::IsEnabled())
+    SetTraceLogLevel(LOG_DEBUG);
 
-  screenWidth = boardW + 40;
-  screenHeight = boardH + 120;
+  // Headless runs still need a GL context for UI::Draw, so they use a hidden
+  // window and run unthrottled.
+  SetConfigFlags(FLAG_WINDOW_UNDECORATED | FLAG_MSAA_4X_HINT |
+                 (headless ? FLAG_WINDOW_HIDDEN : 0));
+  {
+    TRACE_SCOPE("InitWindow");
+    InitWindow(screenWidth, screenHeight, "Minesweeper");
+  }
+  input->Attach();
+  windowReadyMs = MsSinceStart();
+
+  // Decoded once here; UI builds the mine sprite from the same image.
+  {
+    TRACE_SCOPE("Decode assets");
+    const Image &icon = Assets::GetFlagImage();
+    if (icon.data != nullptr)
+      SetWindowIcon(icon);
+  }
+  assetsReadyMs = MsSinceStart();
 
-  SetConfigFlags(FLAG_WINDOW_UNDECORATED | FLAG_MSAA_4X_HINT);
-  InitWindow(screenWidth, screenHeight, "Minesweeper");
+#if !defined(PLATFORM_WEB)
+  // UpdateFrame paces itself so input keeps arriving between frames; the web
+  // build is paced by requestAnimationFrame instead.
+  SetTargetFPS(0);
+#endif
 
-  Image icon = LoadImage("flag.ico");
-  if (icon.data != nullptr) {
-    SetWindowIcon(icon);
-    UnloadImage(icon);
+  // Playback writes keyframes into the board, which would overwrite the
+  // player's saved game, so a replay always runs on heap storage.
+  if (!options.boardFile.empty() && !options.replayFile.empty()) {
+    TraceLog(LOG_WARNING, "REPLAY: Ignoring --board-file during playback");
+  } else if (!options.boardFile.empty() &&
+             board.OpenStorage(options.boardFile)) {
+    if (board.IsGameOver()) {
+      board.Reset();
+    } else {
+      sessionTime = board.GetElapsedTime();
+      resumeTime = sessionTime;
+    }
   }
 
-  SetTargetFPS(60);
+  statManager.SetConfig(CurrentConfig());
+
+  if (!options.replayFile.empty()) {
+    if (player.Open(options.replayFile)) {
+      // Playback uses the recorded board, whatever --size and --mines say.
+      if (player.GetWidth() != board.GetWidth() ||
+          player.GetHeight() != board.GetHeight() ||
+          player.GetMines() != board.GetTotalMines()) {
+        board.Resize(player.GetWidth(), player.GetHeight(), player.GetMines());
+        UpdateWindowSize();
+        SetWindowSize(screenWidth, screenHeight);
+      }
+      StatsKey key = CurrentConfig();
+      key.noGuess = player.IsNoGuess();
+      statManager.SetConfig(key);
+      player.Seek(board, 0);
+    } else {
+      TraceLog(LOG_WARNING, "REPLAY: Could not play back %s",
+               options.replayFile.c_str());
+      player.Close();
+    }
+  }
 }
 
 void Game::UpdateFrame() {
-  Update();
-  Draw();
+#if !defined(PLATFORM_WEB)
+  // Waiting on events rather than sleeping stamps clicks as they arrive, so
+  // their timing does not depend on where in the frame they landed.
+  if (pacing != FramePacing::IDLE) {
+    input->WaitUntil(nextFrameTime);
+    double period = pacing == FramePacing::ACTIVE ? 1.0 / 60.0 : 1.0 / 10.0;
+    nextFrameTime = std::max(nextFrameTime + period, InputSource::Now());
+  }
+#endif
+  TRACE_SCOPE("Frame");
+  AllocTracker::BeginFrame();
+  {
+    AllocScope scope(ALLOC_INPUT);
+    input->BeginFrame();
+  }
+  {
+    AllocScope scope(ALLOC_UPDATE);
+    Update();
+  }
+  // Decided before drawing: EndDrawing polls input, and that poll is where
+  // an idle loop blocks.
+  UpdatePacing();
+  {
+    AllocScope scope(ALLOC_DRAW);
+    Draw();
+  }
+  profiler.EndFrame();
+  if (!startupReported)
+    ReportStartup();
+  if (AllocTracker::GetFrameSteadyCount() > 0) {
+    TraceLog(LOG_DEBUG, "ALLOC: input %zu  update %zu  draw %zu",
+             AllocTracker::GetFrameCount(ALLOC_INPUT),
+             AllocTracker::GetFrameCount(ALLOC_UPDATE),
+             AllocTracker::GetFrameCount(ALLOC_DRAW));
+  }
+}
+
+bool Game::IsAnimating() const {
+  if (player.IsOpen())
+    return !playbackPaused && player.GetPositionMs() < player.GetDurationMs();
+  bool timerRunning = state == GameState::PLAYING && !board.IsFirstClick() &&
+                      !board.IsGameOver() && !board.IsGameWon();
+  bool panning = input->IsKeyDown(KEY_LEFT) || input->IsKeyDown(KEY_RIGHT) ||
+                 input->IsKeyDown(KEY_UP) || input->IsKeyDown(KEY_DOWN);
+  // The profiler graph needs a steady stream of frames to be meaningful.
+  return timerRunning || panning || isDragging || ui.IsEnteringName() ||
+         showProfiler;
 }
 
-void Game::Run() {
+void Game::UpdatePacing() {
+  if (headless)
+    return;
+
+  FramePacing next = FramePacing::IDLE;
+  if (IsWindowMinimized() || IsWindowHidden()) {
+    // Nothing is visible; the timer catches up from the next frame time.
+    next = FramePacing::IDLE;
+  } else if (IsAnimating()) {
+    next = IsWindowFocused() ? FramePacing::ACTIVE : FramePacing::BACKGROUND;
+  }
+  if (next == pacing)
+    return;
+  pacing = next;
+
 #if defined(PLATFORM_WEB)
+  if (pacing == FramePacing::IDLE) {
+    mainLoopPaused = true;
+    emscripten_pause_main_loop();
+  } else if (pacing == FramePacing::BACKGROUND) {
+    emscripten_set_main_loop_timing(EM_TIMING_SETTIMEOUT, 100);
+  } else {
+    emscripten_set_main_loop_timing(EM_TIMING_RAF, 1);
+  }
+#else
+  if (pacing == FramePacing::IDLE) {
+    EnableEventWaiting();
+  } else {
+    DisableEventWaiting();
+  }
+#endif
+}
+
+int Game::Run() {
+  if (headless) {
+    int result = RunHeadless();
+    Assets::Unload();
+    CloseWindow();
+    return result;
+  }
+
+#if defined(PLATFORM_WEB)
+  const char *target = EMSCRIPTEN_EVENT_TARGET_WINDOW;
+  emscripten_set_mousemove_callback(target, nullptr, EM_FALSE,
+                                    WakeMainLoop<EmscriptenMouseEvent>);
+  emscripten_set_mousedown_callback(target, nullptr, EM_FALSE,
+                                    WakeMainLoop<EmscriptenMouseEvent>);
+  emscripten_set_mouseup_callback(target, nullptr, EM_FALSE,
+                                  WakeMainLoop<EmscriptenMouseEvent>);
+  emscripten_set_wheel_callback(target, nullptr, EM_FALSE,
+                                WakeMainLoop<EmscriptenWheelEvent>);
+  emscripten_set_keydown_callback(target, nullptr, EM_FALSE,
+                                  WakeMainLoop<EmscriptenKeyboardEvent>);
+  emscripten_set_keyup_callback(target, nullptr, EM_FALSE,
+                                WakeMainLoop<EmscriptenKeyboardEvent>);
+  emscripten_set_focus_callback(target, nullptr, EM_FALSE,
+                                WakeMainLoop<EmscriptenFocusEvent>);
+  emscripten_set_touchstart_callback(target, nullptr, EM_FALSE,
+                                     WakeMainLoop<EmscriptenTouchEvent>);
   emscripten_set_main_loop_arg(
       [](void *arg) { static_cast<Game *>(arg)->UpdateFrame(); }, this, 0, 1);
 #else
@@ -42,39 +256,198 @@ void Game::Run() {
     UpdateFrame();
   }
 #endif
+  board.Sync();
+  Assets::Unload();
   CloseWindow();
+  return 0;
+}
+
+int Game::RunHeadless() {
+  using Clock = std::chrono::steady_clock;
+  std::vector<double> updateMs;
+  std::vector<double> drawMs;
+  size_t allocatingFrames = 0;
+
+  Clock::time_point start = Clock::now();
+  while (true) {
+    TRACE_SCOPE("Frame");
+    AllocTracker::BeginFrame();
+    {
+      AllocScope scope(ALLOC_INPUT);
+      if (!input->BeginFrame())
+        break;
+    }
+    Clock::time_point t0 = Clock::now();
+    {
+      AllocScope scope(ALLOC_UPDATE);
+      Update();
+    }
+    Clock::time_point t1 = Clock::now();
+    {
+      AllocScope scope(ALLOC_DRAW);
+      Draw();
+    }
+    Clock::time_point t2 = Clock::now();
+    profiler.EndFrame();
+    if (!startupReported)
+      ReportStartup();
+
+    if (AllocTracker::GetFrameSteadyCount() > 0) {
+      allocatingFrames++;
+      TraceLog(LOG_DEBUG, "ALLOC: frame %zu  input %zu  update %zu  draw %zu",
+               updateMs.size(), AllocTracker::GetFrameCount(ALLOC_INPUT),
+               AllocTracker::GetFrameCount(ALLOC_UPDATE),
+               AllocTracker::GetFrameCount(ALLOC_DRAW));
+    }
+    updateMs.push_back(
+        std::chrono::duration<double, std::milli>(t1 - t0).count());
+    drawMs.push_back(std::chrono::duration<double, std::milli>(t2 - t1).count());
+  }
+  double wallSeconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+
+  std::printf("frames: %zu  virtual: %.2fs  wall: %.2fs\n", updateMs.size(),
+              input->GetTime(), wallSeconds);
+  std::printf("board: %s  revealed %d  mines left %d\n",
+              board.IsGameWon()    ? "won"
+              : board.IsGameOver() ? "lost"
+                                   : "playing",
+              board.GetRevealedCount(), board.GetMinesLeft());
+  auto report = [](const char *name, std::vector<double> &ms) {
+    if (ms.empty())
+      return;
+    double sum = 0.0;
+    for (double v : ms)
+      sum += v;
+    std::sort(ms.begin(), ms.end());
+    std::printf("%-7s avg %.3fms  p50 %.3fms  p99 %.3fms  max %.3fms\n", name,
+                sum / ms.size(), ms[ms.size() / 2], ms[ms.size() * 99 / 100],
+                ms.back());
+  };
+  report("update", updateMs);
+  report("draw", drawMs);
+
+  if (!AllocTracker::IsEnabled()) {
+    if (assertNoAlloc) {
+      std::printf("alloc: build with MINESWEEPER_ALLOC_TRACKING to check\n");
+      return 1;
+    }
+    return 0;
+  }
+  std::printf("alloc:  ");
+  for (int i = 0; i < ALLOC_SUBSYSTEM_COUNT; i++) {
+    std::printf(" %s %zu", AllocTracker::GetName((AllocSubsystem)i),
+                AllocTracker::GetTotal((AllocSubsystem)i));
+  }
+  std::printf("\nframes allocating in input/update/draw: %zu\n",
+              allocatingFrames);
+  return assertNoAlloc && allocatingFrames > 0 ? 1 : 0;
+}
+
+void Game::ReportStartup() {
+  startupReported = true;
+  TraceLog(LOG_INFO,
+           "STARTUP: window %.1f ms, assets %.1f ms, first frame %.1f ms",
+           windowReadyMs, assetsReadyMs, MsSinceStart());
+#if defined(PLATFORM_WEB)
+  // performance.now() counts from navigation, so this also covers fetching
+  // and compiling the .wasm, which happen before the program starts.
+  TraceLog(LOG_INFO, "STARTUP: page load to first frame %.1f ms",
+           emscripten_get_now());
+#endif
 }
 
 void Game::ResetGame() {
   if (!board.IsFirstClick() && state == GameState::PLAYING) {
     statManager.RecordIncomplete();
+    FinishGame(ReplayOutcome::INCOMPLETE);
   }
   board.Reset();
+  board.Sync();
   state = GameState::PLAYING;
   sessionTime = 0.0f;
+  resumeTime = -1.0f;
+  moveCount = 0;
+  statManager.SetConfig(CurrentConfig());
+}
+
+void Game::SetDifficulty(int width, int height, int mines) {
+  ResetGame();
+  if (width == board.GetWidth() && height == board.GetHeight() &&
+      mines == board.GetTotalMines())
+    return;
+  board.Resize(width, height, mines);
+  board.Sync();
+  statManager.SetConfig(CurrentConfig());
+  UpdateWindowSize();
+  SetWindowSize(screenWidth, screenHeight);
+}
+
+void Game::UpdateWindowSize() {
+  // Size the window to the board up to expert size; larger boards are
+  // scrolled and zoomed through the UI camera. Small boards still get room
+  // for the stats overlay.
+  int cellS = 32;
+  int boardW = std::min(board.GetWidth(), 30) * cellS;
+  int boardH = std::min(board.GetHeight(), 16) * cellS;
+
+  screenWidth = std::max(boardW, 620) + 40;
+  screenHeight = std::max(boardH, 288) + 135;
+}
+
+StatsKey Game::CurrentConfig() const {
+  StatsKey key;
+  key.width = board.GetWidth();
+  key.height = board.GetHeight();
+  key.mines = board.GetTotalMines();
+  key.noGuess = statManager.GetNoGuessMode();
+  return key;
 }
 
 void Game::Update() {
-  HandleInput();
+  TRACE_SCOPE("Game::Update");
+  {
+    ProfileScope scope(profiler, PHASE_INPUT);
+    HandleInput();
+  }
+  ProfileScope scope(profiler, PHASE_UPDATE);
+
+  if (player.IsOpen()) {
+    UpdatePlayback();
+    return;
+  }
 
   if (state == GameState::PLAYING && !board.IsGameOver() &&
       !board.IsGameWon()) {
     if (!board.IsFirstClick()) {
-      sessionTime += GetFrameTime();
+      if (resumeTime >= 0.0f) {
+        startTime = input->GetTime() - resumeTime;
+        resumeTime = -1.0f;
+      }
+      sessionTime = (float)(input->GetTime() - startTime);
+      board.SetElapsedTime(sessionTime);
       if (sessionTime >= 2000.0f) {
         state = GameState::GAMEOVER;
-        statManager.RecordGame(false, true, sessionTime, 0);
+        statManager.RecordGame(false, true, sessionTime,
+                               board.CountFlaggedMines());
         board.TriggerLose();
+        board.Sync();
+        FinishGame(ReplayOutcome::LOST);
       }
     }
   } else if (state == GameState::PLAYING) {
     if (board.IsGameWon()) {
       state = GameState::WIN;
-      statManager.RecordGame(true, false, sessionTime, 99);
+      statManager.RecordGame(true, false, sessionTime,
+                             board.CountFlaggedMines());
+      FinishGame(ReplayOutcome::WON);
     } else if (board.IsGameOver()) {
       state = GameState::GAMEOVER;
-      statManager.RecordGame(false, true, sessionTime, 0);
+      statManager.RecordGame(false, true, sessionTime,
+                             board.CountFlaggedMines());
+      FinishGame(ReplayOutcome::LOST);
     }
+    board.Sync();
   }
 
   ui.Update(sessionTime);
@@ -84,9 +457,9 @@ void Game::HandleInput() {
   if (ui.IsEnteringName())
     return;
 
-  Vector2 mousePos = GetMousePosition();
+  Vector2 mousePos = input->GetMousePosition();
 
-  if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+  if (input->IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && !headless) {
     if (ui.IsOverClose(mousePos)) {
     } else if (ui.IsOverMinimize(mousePos)) {
       MinimizeWindow();
@@ -97,8 +470,8 @@ void Game::HandleInput() {
   }
 
   if (isDragging) {
-    if (IsMouseButtonDown(MOUSE_LEFT_BUTTON)) {
-      Vector2 currentMouse = GetMousePosition();
+    if (input->IsMouseButtonDown(MOUSE_LEFT_BUTTON)) {
+      Vector2 currentMouse = input->GetMousePosition();
       Vector2 delta = {currentMouse.x - dragOffset.x,
                        currentMouse.y - dragOffset.y};
       Vector2 windowPos = GetWindowPosition();
@@ -110,73 +483,213 @@ void Game::HandleInput() {
     }
   }
 
-  if (ui.IsOverClose(mousePos) && IsMouseButtonReleased(MOUSE_LEFT_BUTTON)) {
+  if (ui.IsOverClose(mousePos) &&
+      input->IsMouseButtonReleased(MOUSE_LEFT_BUTTON) && !headless) {
+    board.Sync();
+    // exit() skips Game's destructor, and with it the stats writer's.
+    statManager.Flush();
     exit(0);
   }
 
-  if (IsKeyPressed(KEY_R)) {
+  ui.UpdateCamera(!player.IsOpen());
+
+  if (input->IsKeyPressed(KEY_P)) {
+    showProfiler = !showProfiler;
+  }
+  if (input->IsKeyPressed(KEY_F3)) {
+    ExportProfile();
+  }
+
+  if (player.IsOpen())
+    return;
+
+  if (input->IsKeyPressed(KEY_R)) {
     ResetGame();
   }
 
   if ((board.IsGameOver() || board.IsGameWon())) {
-    if (GetKeyPressed() != 0) {
+    if (input->GetKeyPressed() != 0) {
       ResetGame();
     }
   }
 
-  if (IsKeyPressed(KEY_S)) {
+  if (input->IsKeyPressed(KEY_S)) {
     showStats = !showStats;
   }
 
-  if (IsKeyPressed(KEY_G)) {
+  if (showStats && input->IsKeyPressed(KEY_TAB)) {
+    ui.ToggleStatsTrends();
+  }
+
+  if (input->IsKeyPressed(KEY_F2)) {
+    ui.SetGridShader(!ui.IsGridShader());
+  }
+
+  if (input->IsKeyPressed(KEY_G)) {
     statManager.SetNoGuessMode(!statManager.GetNoGuessMode());
+    // A game in progress keeps the mode it started with.
+    if (board.IsFirstClick())
+      statManager.SetConfig(CurrentConfig());
+  }
+
+  for (int i = 0; i < 3; i++) {
+    if (input->IsKeyPressed(KEY_ONE + i)) {
+      const Difficulty &d = difficulties[i];
+      SetDifficulty(d.width, d.height, d.mines);
+    }
   }
 
   if (showStats || isDragging)
     return;
 
-  int cellSize = 32;
-  int offsetX = (screenWidth - board.GetWidth() * cellSize) / 2;
-  int offsetY = 95 + 20;
-  int gridX = (int)(mousePos.x - offsetX) / cellSize;
-  int gridY = (int)(mousePos.y - offsetY) / cellSize;
-
-  if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-    if (board.IsValid(gridX, gridY)) {
-      bool wasFirst = board.IsFirstClick();
-
-      float currentTime = (float)GetTime();
-      if (board.GetCell(gridX, gridY).isRevealed) {
-        board.Chord(gridX, gridY);
-      } else {
-        board.Reveal(gridX, gridY);
-      }
+  // Clicks are applied in the order and at the position they happened,
+  // using the time they were stamped with.
+  for (int i = 0; i < input->GetEventCount(); i++) {
+    const InputEvent &event = input->GetEvent(i);
+    int gridX, gridY;
+    if (event.type != InputEventType::MOUSE_PRESSED ||
+        !ui.ScreenToCell(event.position, gridX, gridY))
+      continue;
 
-      if (wasFirst && !board.IsFirstClick()) {
-        if (statManager.GetNoGuessMode()) {
-          board.GenerateNoGuess(gridX, gridY);
-        }
-        statManager.RecordStart();
-      }
+    if (event.button == MOUSE_LEFT_BUTTON) {
+      ApplyMove(board.GetCell(gridX, gridY).isRevealed ? ReplayAction::CHORD
+                                                       : ReplayAction::REVEAL,
+                gridX, gridY, event.time);
 
-      lastClickTime = currentTime;
+      lastClickTime = (float)event.time;
       lastX = gridX;
       lastY = gridY;
+    } else if (event.button == MOUSE_RIGHT_BUTTON) {
+      ApplyMove(ReplayAction::FLAG, gridX, gridY, event.time);
+    } else if (event.button == MOUSE_MIDDLE_BUTTON) {
+      ApplyMove(ReplayAction::CHORD, gridX, gridY, event.time);
     }
-  } else if (IsMouseButtonPressed(MOUSE_RIGHT_BUTTON)) {
-    if (board.IsValid(gridX, gridY)) {
-      board.ToggleFlag(gridX, gridY);
-    }
-  } else if (IsMouseButtonPressed(MOUSE_MIDDLE_BUTTON)) {
-    if (board.IsValid(gridX, gridY)) {
-      board.Chord(gridX, gridY);
-    }
+    if (board.IsGameOver() || board.IsGameWon())
+      break;
+  }
+}
+
+void Game::ApplyMove(ReplayAction action, int x, int y, double time) {
+  bool wasFirst = board.IsFirstClick();
+  if (wasFirst && action == ReplayAction::REVEAL) {
+    uint32_t seed;
+    if (input->ReplaySeed(seed))
+      board.SetSeed(seed);
+    else
+      input->RecordSeed(board.GetSeed());
+    replay.Begin(board, statManager.GetNoGuessMode());
+  }
+
+  ApplyReplayAction(board, action, x, y, statManager.GetNoGuessMode());
+
+  moveCount++;
+  if (wasFirst && !board.IsFirstClick()) {
+    statManager.SetConfig(CurrentConfig());
+    statManager.RecordStart();
+    startTime = time;
+  }
+  float moveTime = (float)(time - startTime);
+  if (board.IsGameOver() || board.IsGameWon()) {
+    // The result is timed to the deciding click, not the next frame.
+    sessionTime = moveTime;
+    board.SetElapsedTime(sessionTime);
   }
+  replay.Record(action, x, y, moveTime, board);
+}
+
+void Game::FinishGame(ReplayOutcome outcome) {
+  AllocScope scope(ALLOC_STORAGE);
+  GameRecord record;
+  record.timestamp = (int64_t)std::time(nullptr);
+  record.config = statManager.GetConfig();
+  record.seed = board.GetSeed();
+  record.durationMs = (uint32_t)(std::max(sessionTime, 0.0f) * 1000.0f);
+  record.clicks = (uint32_t)moveCount;
+  record.bbbv = (uint32_t)board.Get3BV();
+  record.outcome = (uint8_t)outcome;
+  statManager.RecordHistory(record);
+
+  if (!replay.IsRecording())
+    return;
+  replay.End(sessionTime, outcome);
+  // Trace runs are measurements; their games are not the player's to keep.
+  if (headless)
+    return;
+
+#if !defined(PLATFORM_WEB)
+  // Milliseconds keep a game lost on its first click from sharing a name
+  // with the one before it.
+  auto now = std::chrono::system_clock::now();
+  std::time_t seconds = std::chrono::system_clock::to_time_t(now);
+  int ms = (int)(std::chrono::duration_cast<std::chrono::milliseconds>(
+                     now.time_since_epoch())
+                     .count() %
+                 1000);
+  char name[64];
+  size_t length = std::strftime(name, sizeof(name), "replays/%Y%m%d-%H%M%S",
+                                std::localtime(&seconds));
+  std::snprintf(name + length, sizeof(name) - length, "-%03d.msr", ms);
+  std::vector<unsigned char> bytes;
+  if (replay.Serialize(bytes))
+    statManager.SaveReplay(name, std::move(bytes));
+#endif
+}
+
+void Game::ExportProfile() {
+  AllocScope scope(ALLOC_STORAGE);
+  char name[64];
+  std::time_t now = std::time(nullptr);
+  std::strftime(name, sizeof(name), "profile-%Y%m%d-%H%M%S.csv",
+                std::localtime(&now));
+  if (profiler.ExportCsv(name)) {
+    TraceLog(LOG_INFO, "PROFILE: Wrote %s", name);
+  } else {
+    TraceLog(LOG_WARNING, "PROFILE: Could not write %s", name);
+  }
+}
+
+void Game::UpdatePlayback() {
+  if (input->IsKeyPressed(KEY_SPACE)) {
+    playbackPaused = !playbackPaused;
+  }
+
+  float duration = player.GetDurationMs() / 1000.0f;
+  float target = sessionTime;
+  if (!playbackPaused) {
+    target += input->GetFrameTime();
+  }
+  if (input->IsKeyPressed(KEY_RIGHT)) {
+    target += 5.0f;
+  }
+  if (input->IsKeyPressed(KEY_LEFT) || input->IsKeyPressed(KEY_R)) {
+    target = input->IsKeyPressed(KEY_R) ? 0.0f : target - 5.0f;
+  }
+  if (target < 0.0f)
+    target = 0.0f;
+  if (target > duration)
+    target = duration;
+
+  uint32_t targetMs = (uint32_t)(target * 1000.0f);
+  if (target < sessionTime) {
+    player.Seek(board, targetMs);
+  } else {
+    player.Advance(board, targetMs);
+  }
+  sessionTime = target;
 }
 
 void Game::Draw() {
+  TRACE_SCOPE("Game::Draw");
   BeginDrawing();
   ClearBackground(Color{28, 32, 38, 255});
-  ui.Draw(sessionTime, showStats);
+  {
+    ProfileScope scope(profiler, PHASE_DRAW);
+    ui.Draw(sessionTime, moveCount, showStats);
+  }
+  if (showProfiler) {
+    profiler.Draw(10, GetScreenHeight() - 210);
+  }
+  ProfileScope scope(profiler, PHASE_PRESENT);
+  TRACE_SCOPE("EndDrawing");
   EndDrawing();
 }
@@ -1,15 +1,35 @@
 #pragma once
 #include "Board.h"
+#include "FrameProfiler.h"
+#include "Input.h"
+#include "Replay.h"
 #include "StatManager.h"
 #include "UI.h"
+#include <memory>
+#include <string>
 
 
 enum class GameState { MENU, PLAYING, GAMEOVER, WIN };
 
+// How often the main loop runs: every display frame, throttled while a game
+// runs in an unfocused window, or blocked until the next input event.
+enum class FramePacing { ACTIVE, BACKGROUND, IDLE };
+
+struct GameOptions {
+  std::string boardFile;  // Keep the board in this memory-mapped file
+  std::string replayFile; // Play back this replay instead of a live game
+  std::string traceFile;  // Drive the game headlessly from this input trace
+  std::string recordTraceFile; // Write live input to this trace
+  bool assertNoAlloc = false; // Fail a trace run whose frames allocate
+  int boardWidth = 30;
+  int boardHeight = 16;
+  int boardMines = 99;
+};
+
 class Game {
 public:
-  Game();
-  void Run();
+  Game(const GameOptions &options = GameOptions());
+  int Run();
   void UpdateFrame();
 
 private:
@@ -17,20 +37,52 @@ private:
   void Draw();
   void HandleInput();
   void ResetGame();
+  // Abandons the current game and starts a board of the given size.
+  void SetDifficulty(int width, int height, int mines);
+  void UpdateWindowSize();
+  StatsKey CurrentConfig() const;
+  void ApplyMove(ReplayAction action, int x, int y, double time);
+  // Adds the ended game to the history and saves its replay.
+  void FinishGame(ReplayOutcome outcome);
+  void ExportProfile();
+  void UpdatePlayback();
+  int RunHeadless();
+  bool IsAnimating() const;
+  void UpdatePacing();
+  void ReportStartup();
 
   int screenWidth;
   int screenHeight;
 
   GameState state;
   Board board;
+  std::unique_ptr<InputSource> input;
+  bool headless = false;
+  bool assertNoAlloc = false;
   UI ui;
   StatManager statManager;
+  ReplayWriter replay;
+  ReplayReader player;
+  bool playbackPaused = false;
+  FrameProfiler profiler;
+  bool showProfiler = false;
+  FramePacing pacing = FramePacing::ACTIVE;
+  // Startup milestones in ms since process start.
+  float windowReadyMs = 0.0f;
+  float assetsReadyMs = 0.0f;
+  bool startupReported = false;
+  double nextFrameTime = 0.0; // On the input clock
 
   float lastClickTime = 0.0f;
   int lastX = -1;
   int lastY = -1;
 
+  // Game time is measured from the first reveal on the input clock rather
+  // than summed from frame times.
+  double startTime = 0.0;
+  float resumeTime = -1.0f; // Saved time of a game restored from disk
   float sessionTime = 0.0f;
+  int moveCount = 0; // Reveals, flags and chords this game
   bool showStats = false;
 
   // Window dragging
@@ -0,0 +1,293 @@
+#include "GameHistory.h"
+#include "Replay.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+struct HistoryFileHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t chunkRows;
+  uint32_t columnCount;
+  uint32_t chunkBytes;
+  uint32_t reserved[3];
+};
+static_assert(sizeof(HistoryFileHeader) == 32,
+              "HistoryFileHeader layout changed");
+
+const char historyMagic[4] = {'M', 'S', 'H', 'S'};
+const uint32_t historyVersion = 1;
+
+// Width in bytes of each column's values. Width, height and mines are
+// int32_t like StatsKey; the other 4-byte columns are uint32_t.
+const int columnWidth[COLUMN_COUNT] = {8, 4, 4, 4, 1, 4, 4, 4, 4, 1};
+const uint8_t outcomeWon = (uint8_t)ReplayOutcome::WON;
+
+struct ChunkLayout {
+  size_t offsets[COLUMN_COUNT];
+  size_t size;
+
+  ChunkLayout() {
+    // Every column array starts 8-byte aligned, so a mapped chunk can be
+    // read through typed pointers.
+    size_t at = sizeof(HistoryChunkHeader);
+    for (int c = 0; c < COLUMN_COUNT; c++) {
+      offsets[c] = at;
+      at += (columnWidth[c] * GameHistory::chunkRows + 7) & ~(size_t)7;
+    }
+    size = at;
+  }
+};
+const ChunkLayout layout;
+
+size_t ChunkOffset(size_t chunk) {
+  return sizeof(HistoryFileHeader) + chunk * layout.size;
+}
+
+template <typename T> const T *Column(const unsigned char *chunk, int column) {
+  return reinterpret_cast<const T *>(chunk + layout.offsets[column]);
+}
+
+bool Seek(FILE *file, size_t offset) {
+  return std::fseek(file, (long)offset, SEEK_SET) == 0;
+}
+
+} // namespace
+
+GameHistory::~GameHistory() { Close(); }
+
+bool GameHistory::Open(const std::string &path) {
+  TRACE_SCOPE("GameHistory::Open");
+  Close();
+  this->path = path;
+
+  HistoryFileHeader header = {};
+  file = std::fopen(path.c_str(), "r+b");
+  if (file != nullptr) {
+    bool valid =
+        std::fread(&header, sizeof(header), 1, file) == 1 &&
+        std::memcmp(header.magic, historyMagic, sizeof(historyMagic)) == 0 &&
+        header.version == historyVersion && header.chunkRows == chunkRows &&
+        header.columnCount == COLUMN_COUNT && header.chunkBytes == layout.size;
+    if (!valid) {
+      std::fclose(file);
+      file = nullptr;
+      std::string damaged = path + ".bad";
+      std::remove(damaged.c_str());
+      std::rename(path.c_str(), damaged.c_str());
+    }
+  }
+
+  if (file == nullptr) {
+    file = std::fopen(path.c_str(), "w+b");
+    if (file == nullptr)
+      return false;
+    std::memcpy(header.magic, historyMagic, sizeof(historyMagic));
+    header.version = historyVersion;
+    header.chunkRows = chunkRows;
+    header.columnCount = COLUMN_COUNT;
+    header.chunkBytes = (uint32_t)layout.size;
+    if (std::fwrite(&header, sizeof(header), 1, file) != 1 ||
+        std::fflush(file) != 0) {
+      Close();
+      return false;
+    }
+    return true;
+  }
+
+  // A chunk cut short by a crash while it was being added is dropped here
+  // and written again by the next append.
+  std::fseek(file, 0, SEEK_END);
+  long size = std::ftell(file);
+  size_t chunkCount = size > (long)sizeof(header)
+                          ? (size - sizeof(header)) / layout.size
+                          : 0;
+  chunks.reserve(chunkCount);
+  for (size_t i = 0; i < chunkCount; i++) {
+    HistoryChunkHeader chunk;
+    if (!Seek(file, ChunkOffset(i)) ||
+        std::fread(&chunk, sizeof(chunk), 1, file) != 1 ||
+        chunk.rowCount > chunkRows)
+      break;
+    chunks.push_back(chunk);
+    rowCount += chunk.rowCount;
+  }
+  return true;
+}
+
+void GameHistory::Close() {
+  if (file != nullptr)
+    std::fclose(file);
+  file = nullptr;
+  view.Close();
+  chunks.clear();
+  rowCount = 0;
+  viewRows = 0;
+}
+
+void GameHistory::Attach(const std::string &path,
+                         const std::vector<HistoryChunkHeader> &chunks) {
+  Close();
+  this->path = path;
+  this->chunks = chunks;
+  for (const HistoryChunkHeader &chunk : chunks)
+    rowCount += chunk.rowCount;
+}
+
+bool GameHistory::AddChunk() {
+  // Writing the last byte extends the file; the column arrays read as zero
+  // until rows are written into them.
+  size_t offset = ChunkOffset(chunks.size());
+  if (!Seek(file, offset + layout.size - 1) || std::fputc(0, file) == EOF)
+    return false;
+
+  HistoryChunkHeader chunk = {};
+  for (int c = 0; c < COLUMN_COUNT; c++) {
+    chunk.min[c] = INT64_MAX;
+    chunk.max[c] = INT64_MIN;
+  }
+  if (!Seek(file, offset) || std::fwrite(&chunk, sizeof(chunk), 1, file) != 1)
+    return false;
+  chunks.push_back(chunk);
+  return true;
+}
+
+bool GameHistory::Append(const GameRecord &record) {
+  TRACE_SCOPE("GameHistory::Append");
+  if (file == nullptr)
+    return false;
+  if ((chunks.empty() || chunks.back().rowCount == chunkRows) && !AddChunk())
+    return false;
+
+  int64_t values[COLUMN_COUNT];
+  values[COLUMN_TIMESTAMP] = record.timestamp;
+  values[COLUMN_WIDTH] = record.config.width;
+  values[COLUMN_HEIGHT] = record.config.height;
+  values[COLUMN_MINES] = record.config.mines;
+  values[COLUMN_NO_GUESS] = record.config.noGuess ? 1 : 0;
+  values[COLUMN_SEED] = record.seed;
+  values[COLUMN_DURATION] = record.durationMs;
+  values[COLUMN_CLICKS] = record.clicks;
+  values[COLUMN_BBBV] = record.bbbv;
+  values[COLUMN_OUTCOME] = record.outcome;
+
+  HistoryChunkHeader &chunk = chunks.back();
+  size_t offset = ChunkOffset(chunks.size() - 1);
+  for (int c = 0; c < COLUMN_COUNT; c++) {
+    int64_t value = values[c];
+    uint8_t byte = (uint8_t)value;
+    uint32_t word = (uint32_t)value;
+    const void *bytes = columnWidth[c] == 8   ? (const void *)&value
+                        : columnWidth[c] == 4 ? (const void *)&word
+                                              : (const void *)&byte;
+    size_t at = offset + layout.offsets[c] + chunk.rowCount * columnWidth[c];
+    if (!Seek(file, at) || std::fwrite(bytes, columnWidth[c], 1, file) != 1)
+      return false;
+    chunk.min[c] = std::min(chunk.min[c], value);
+    chunk.max[c] = std::max(chunk.max[c], value);
+  }
+
+  chunk.rowCount++;
+  if (!Seek(file, offset) || std::fwrite(&chunk, sizeof(chunk), 1, file) != 1 ||
+      std::fflush(file) != 0) {
+    chunk.rowCount--;
+    return false;
+  }
+  rowCount++;
+  return true;
+}
+
+const unsigned char *GameHistory::MapChunk(size_t chunk) const {
+  if (!view.IsOpen() || viewRows != rowCount) {
+    if (!view.OpenReadOnly(path))
+      return nullptr;
+    viewRows = rowCount;
+  }
+  if (view.Size() < ChunkOffset(chunk) + layout.size)
+    return nullptr;
+  return view.Data() + ChunkOffset(chunk);
+}
+
+// Calls `visit(chunk, row)` for each row of `key` from `since` on. Chunks
+// whose zone map excludes the key or time range are never touched, and a
+// chunk holding only that key skips the per-row key check.
+template <typename Fn>
+void GameHistory::Scan(const StatsKey &key, int64_t since, Fn visit) const {
+  const int keyColumns[] = {COLUMN_WIDTH, COLUMN_HEIGHT, COLUMN_MINES,
+                            COLUMN_NO_GUESS};
+  const int64_t keyValues[] = {key.width, key.height, key.mines,
+                               key.noGuess ? 1 : 0};
+
+  for (size_t i = 0; i < chunks.size(); i++) {
+    const HistoryChunkHeader &header = chunks[i];
+    if (header.rowCount == 0 || header.max[COLUMN_TIMESTAMP] < since)
+      continue;
+    bool excluded = false;
+    bool uniform = header.min[COLUMN_TIMESTAMP] >= since;
+    for (int k = 0; k < 4; k++) {
+      int c = keyColumns[k];
+      excluded |= keyValues[k] < header.min[c] || keyValues[k] > header.max[c];
+      uniform &= header.min[c] == header.max[c];
+    }
+    if (excluded)
+      continue;
+
+    const unsigned char *chunk = MapChunk(i);
+    if (chunk == nullptr)
+      return;
+    if (uniform) {
+      for (uint32_t row = 0; row < header.rowCount; row++)
+        visit(chunk, row);
+      continue;
+    }
+
+    const int64_t *timestamps = Column<int64_t>(chunk, COLUMN_TIMESTAMP);
+    const int32_t *widths = Column<int32_t>(chunk, COLUMN_WIDTH);
+    const int32_t *heights = Column<int32_t>(chunk, COLUMN_HEIGHT);
+    const int32_t *mines = Column<int32_t>(chunk, COLUMN_MINES);
+    const uint8_t *noGuess = Column<uint8_t>(chunk, COLUMN_NO_GUESS);
+    for (uint32_t row = 0; row < header.rowCount; row++) {
+      if (timestamps[row] >= since && widths[row] == key.width &&
+          heights[row] == key.height && mines[row] == key.mines &&
+          noGuess[row] == (key.noGuess ? 1 : 0))
+        visit(chunk, row);
+    }
+  }
+}
+
+void GameHistory::QueryDays(const StatsKey &key, int64_t now, int dayCount,
+                            HistoryDay *days) const {
+  TRACE_SCOPE("GameHistory::QueryDays");
+  std::fill(days, days + dayCount, HistoryDay());
+  const int64_t day = 24 * 60 * 60;
+  Scan(key, now - dayCount * day,
+       [&](const unsigned char *chunk, uint32_t row) {
+         int64_t age = now - Column<int64_t>(chunk, COLUMN_TIMESTAMP)[row];
+         int index = (int)std::min<int64_t>(std::max<int64_t>(age, 0) / day,
+                                            dayCount - 1);
+         HistoryDay &d = days[index];
+         d.games++;
+         if (Column<uint8_t>(chunk, COLUMN_OUTCOME)[row] == outcomeWon) {
+           d.wins++;
+           d.winTimeSum +=
+               Column<uint32_t>(chunk, COLUMN_DURATION)[row] / 1000.0;
+         }
+       });
+}
+
+void GameHistory::QueryBy3BV(const StatsKey &key, int bucketSize,
+                             int bucketCount, HistoryBucket *buckets) const {
+  TRACE_SCOPE("GameHistory::QueryBy3BV");
+  std::fill(buckets, buckets + bucketCount, HistoryBucket());
+  Scan(key, INT64_MIN, [&](const unsigned char *chunk, uint32_t row) {
+    if (Column<uint8_t>(chunk, COLUMN_OUTCOME)[row] != outcomeWon)
+      return;
+    uint32_t bbbv = Column<uint32_t>(chunk, COLUMN_BBBV)[row];
+    HistoryBucket &b =
+        buckets[std::min<uint32_t>(bbbv / bucketSize, bucketCount - 1)];
+    b.wins++;
+    b.winTimeSum += Column<uint32_t>(chunk, COLUMN_DURATION)[row] / 1000.0;
+  });
+}
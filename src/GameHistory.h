@@ -0,0 +1,103 @@
+#pragma once
+#include "MappedFile.h"
+#include "StatJournal.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// One finished or abandoned game.
+struct GameRecord {
+  int64_t timestamp = 0; // Unix seconds when the game ended
+  StatsKey config;
+  uint32_t seed = 0;
+  uint32_t durationMs = 0;
+  uint32_t clicks = 0;
+  uint32_t bbbv = 0;   // Minimum clicks needed to clear the board
+  uint8_t outcome = 0; // ReplayOutcome
+};
+
+enum HistoryColumn {
+  COLUMN_TIMESTAMP,
+  COLUMN_WIDTH,
+  COLUMN_HEIGHT,
+  COLUMN_MINES,
+  COLUMN_NO_GUESS,
+  COLUMN_SEED,
+  COLUMN_DURATION,
+  COLUMN_CLICKS,
+  COLUMN_BBBV,
+  COLUMN_OUTCOME,
+  COLUMN_COUNT
+};
+
+// Zone map at the start of every chunk. `rowCount` is written after the
+// row's values, so a row torn by a crash is never counted.
+struct HistoryChunkHeader {
+  uint32_t rowCount;
+  uint32_t reserved;
+  int64_t min[COLUMN_COUNT];
+  int64_t max[COLUMN_COUNT];
+};
+
+struct HistoryDay {
+  int games = 0;
+  int wins = 0;
+  double winTimeSum = 0.0; // Seconds
+};
+
+struct HistoryBucket {
+  int wins = 0;
+  double winTimeSum = 0.0; // Seconds
+};
+
+// Per-game history in a columnar file: a header, then chunks of chunkRows
+// rows, each a zone map followed by one fixed-width array per column.
+// Queries skip chunks whose min/max rule them out and only read the column
+// arrays they use, through a read-only mapping. Values are stored in host
+// byte order, like the journal.
+class GameHistory {
+public:
+  static constexpr uint32_t chunkRows = 4096;
+
+  GameHistory() = default;
+  ~GameHistory();
+  GameHistory(const GameHistory &) = delete;
+  GameHistory &operator=(const GameHistory &) = delete;
+
+  // Reads only the chunk headers; a damaged file is renamed to
+  // `path` + ".bad" and a new one started.
+  bool Open(const std::string &path);
+  void Close();
+  bool Append(const GameRecord &record);
+  // Queries the file at `path` using zone maps taken from the instance that
+  // appends to it, without opening the file for writing.
+  void Attach(const std::string &path,
+              const std::vector<HistoryChunkHeader> &chunks);
+
+  size_t GetRowCount() const { return rowCount; }
+  const std::vector<HistoryChunkHeader> &GetChunks() const { return chunks; }
+
+  // Per-day games, wins and win time for `key`, day 0 being the 24 hours
+  // before `now`.
+  void QueryDays(const StatsKey &key, int64_t now, int dayCount,
+                 HistoryDay *days) const;
+  // Wins and win time for `key` bucketed by 3BV; the last bucket takes
+  // everything above.
+  void QueryBy3BV(const StatsKey &key, int bucketSize, int bucketCount,
+                  HistoryBucket *buckets) const;
+
+private:
+  template <typename Fn>
+  void Scan(const StatsKey &key, int64_t since, Fn visit) const;
+  const unsigned char *MapChunk(size_t chunk) const;
+  bool AddChunk();
+
+  std::string path;
+  FILE *file = nullptr;
+  std::vector<HistoryChunkHeader> chunks;
+  size_t rowCount = 0;
+  // Remapped by queries once rows have been appended since the last map.
+  mutable MappedFile view;
+  mutable size_t viewRows = 0;
+};
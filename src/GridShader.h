@@ -0,0 +1,48 @@
+#pragma once
+
+// Fragment shader that draws the whole board from one quad. texture0 is the
+// cell-state texture (one texel per cell holding a CellVisual), `sprites` is
+// the SpriteAtlas strip with one baked cell image per CellVisual.
+#if defined(PLATFORM_WEB)
+static const char *gridFragmentShader = R"(#version 100
+#ifdef GL_FRAGMENT_PRECISION_HIGH
+precision highp float;
+#else
+precision mediump float;
+#endif
+varying vec2 fragTexCoord;
+varying vec4 fragColor;
+uniform sampler2D texture0;
+uniform sampler2D sprites;
+uniform vec2 gridSize;
+uniform float spriteCount;
+
+void main() {
+  vec2 cellPos = fragTexCoord * gridSize;
+  vec2 cell = floor(cellPos);
+  vec2 local = cellPos - cell;
+  float state = floor(texture2D(texture0, (cell + 0.5) / gridSize).r * 255.0 + 0.5);
+  vec2 uv = vec2((state + local.x) / spriteCount, local.y);
+  gl_FragColor = texture2D(sprites, uv) * fragColor;
+}
+)";
+#else
+static const char *gridFragmentShader = R"(#version 330
+in vec2 fragTexCoord;
+in vec4 fragColor;
+uniform sampler2D texture0;
+uniform sampler2D sprites;
+uniform vec2 gridSize;
+uniform float spriteCount;
+out vec4 finalColor;
+
+void main() {
+  vec2 cellPos = fragTexCoord * gridSize;
+  vec2 cell = floor(cellPos);
+  vec2 local = cellPos - cell;
+  float state = floor(texture(texture0, (cell + 0.5) / gridSize).r * 255.0 + 0.5);
+  vec2 uv = vec2((state + local.x) / spriteCount, local.y);
+  finalColor = texture(sprites, uv) * fragColor;
+}
+)";
+#endif
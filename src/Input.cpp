@@ -0,0 +1,254 @@
+#include "Input.h"
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+
+// Keys whose held state the game polls; their down state is captured each
+// frame so traces can reproduce key repeat.
+static const int watchedKeys[] = {KEY_BACKSPACE, KEY_LEFT, KEY_RIGHT, KEY_UP,
+                                  KEY_DOWN};
+
+// GLFW callbacks carry no user pointer raylib leaves free, so the attached
+// input and the callback it displaced are kept here.
+static RaylibInput *attachedInput = nullptr;
+static GLFWmousebuttonfun raylibMouseButtonCallback = nullptr;
+
+static void MouseButtonCallback(GLFWwindow *window, int button, int action,
+                                int mods) {
+  if (attachedInput != nullptr && action != GLFW_REPEAT) {
+    InputEvent event;
+    event.time = InputSource::Now();
+    double x = 0.0, y = 0.0;
+    glfwGetCursorPos(window, &x, &y);
+    event.position = {(float)x, (float)y};
+    event.type = action == GLFW_PRESS ? InputEventType::MOUSE_PRESSED
+                                      : InputEventType::MOUSE_RELEASED;
+    event.button = button;
+    attachedInput->PushEvent(event);
+  }
+  if (raylibMouseButtonCallback != nullptr)
+    raylibMouseButtonCallback(window, button, action, mods);
+}
+
+double InputSource::Now() {
+  static const std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+bool InputSource::BeginFrame() {
+  FrameInput next;
+  if (!Poll(next))
+    return false;
+  frame = next;
+  keyCursor = 0;
+  charCursor = 0;
+  return true;
+}
+
+bool InputSource::IsMouseButtonPressed(int button) const {
+  return (frame.buttonsPressed >> button) & 1;
+}
+
+bool InputSource::IsMouseButtonDown(int button) const {
+  return (frame.buttonsDown >> button) & 1;
+}
+
+bool InputSource::IsMouseButtonReleased(int button) const {
+  return (frame.buttonsReleased >> button) & 1;
+}
+
+bool InputSource::IsKeyPressed(int key) const {
+  for (int i = 0; i < frame.keyCount; i++) {
+    if (frame.keys[i] == key)
+      return true;
+  }
+  return false;
+}
+
+bool InputSource::IsKeyDown(int key) const {
+  for (int i = 0; i < frame.downCount; i++) {
+    if (frame.downKeys[i] == key)
+      return true;
+  }
+  return false;
+}
+
+int InputSource::GetKeyPressed() {
+  return keyCursor < frame.keyCount ? frame.keys[keyCursor++] : 0;
+}
+
+int InputSource::GetCharPressed() {
+  return charCursor < frame.charCount ? frame.chars[charCursor++] : 0;
+}
+
+RaylibInput::RaylibInput(const std::string &tracePath) {
+  if (!tracePath.empty()) {
+    trace = std::fopen(tracePath.c_str(), "w");
+  }
+}
+
+RaylibInput::~RaylibInput() {
+  if (trace != nullptr)
+    std::fclose(trace);
+  if (attachedInput == this)
+    attachedInput = nullptr;
+}
+
+void RaylibInput::Attach() {
+  GLFWwindow *window = glfwGetCurrentContext();
+  if (window == nullptr)
+    return;
+  attachedInput = this;
+  raylibMouseButtonCallback =
+      glfwSetMouseButtonCallback(window, MouseButtonCallback);
+}
+
+void RaylibInput::WaitUntil(double time) {
+#if !defined(PLATFORM_WEB)
+  // Each event wakes the wait early and runs its callback right away.
+  for (double now = Now(); now < time; now = Now()) {
+    glfwWaitEventsTimeout(time - now);
+  }
+#else
+  (void)time;
+#endif
+}
+
+void RaylibInput::RecordSeed(uint32_t seed) {
+  // Follows the line of the frame whose click started the game.
+  if (trace != nullptr)
+    std::fprintf(trace, "seed %u\n", seed);
+}
+
+bool RaylibInput::Poll(FrameInput &next) {
+  next.time = Now();
+  next.frameTime =
+      lastTime < 0.0 ? ::GetFrameTime() : (float)(next.time - lastTime);
+  lastTime = next.time;
+  next.mouse = ::GetMousePosition();
+  for (int button = MOUSE_BUTTON_LEFT; button <= MOUSE_BUTTON_MIDDLE;
+       button++) {
+    next.buttonsPressed |= ::IsMouseButtonPressed(button) << button;
+    next.buttonsDown |= ::IsMouseButtonDown(button) << button;
+    next.buttonsReleased |= ::IsMouseButtonReleased(button) << button;
+  }
+  next.wheel = ::GetMouseWheelMove();
+  while (next.eventCount < 16 && events.Pop(next.events[next.eventCount])) {
+    next.eventCount++;
+  }
+
+  for (int key = ::GetKeyPressed(); key != 0; key = ::GetKeyPressed()) {
+    if (next.keyCount < 16)
+      next.keys[next.keyCount++] = key;
+  }
+  for (int key : watchedKeys) {
+    if (::IsKeyDown(key) && next.downCount < 8)
+      next.downKeys[next.downCount++] = key;
+  }
+  for (int ch = ::GetCharPressed(); ch != 0; ch = ::GetCharPressed()) {
+    if (next.charCount < 16)
+      next.chars[next.charCount++] = ch;
+  }
+
+  if (trace != nullptr) {
+    std::fprintf(trace, "%.6f %.1f %.1f %d %d %d %d", next.frameTime,
+                 next.mouse.x, next.mouse.y, next.buttonsPressed,
+                 next.buttonsDown, next.buttonsReleased, next.keyCount);
+    for (int i = 0; i < next.keyCount; i++)
+      std::fprintf(trace, " %d", next.keys[i]);
+    std::fprintf(trace, " %d", next.downCount);
+    for (int i = 0; i < next.downCount; i++)
+      std::fprintf(trace, " %d", next.downKeys[i]);
+    std::fprintf(trace, " %d", next.charCount);
+    for (int i = 0; i < next.charCount; i++)
+      std::fprintf(trace, " %d", next.chars[i]);
+    std::fprintf(trace, " %.3f %d", next.wheel, next.eventCount);
+    // Event times are stored as their age relative to the frame.
+    for (int i = 0; i < next.eventCount; i++) {
+      const InputEvent &e = next.events[i];
+      std::fprintf(trace, " %d %d %.1f %.1f %.6f", (int)e.type, e.button,
+                   e.position.x, e.position.y, next.time - e.time);
+    }
+    std::fprintf(trace, "\n");
+  }
+  return true;
+}
+
+bool TraceInput::Load(const std::string &path) {
+  std::ifstream in(path);
+  if (!in.is_open())
+    return false;
+
+  frames.clear();
+  position = 0;
+  seeds.clear();
+  seedPosition = 0;
+  double clock = 0.0;
+  std::string line;
+  while (std::getline(in, line)) {
+    std::istringstream ss(line);
+    if (line.compare(0, 5, "seed ") == 0) {
+      std::string word;
+      uint32_t seed;
+      if (ss >> word >> seed)
+        seeds.push_back(seed);
+      continue;
+    }
+    FrameInput f;
+    int pressed = 0, down = 0, released = 0;
+    if (!(ss >> f.frameTime >> f.mouse.x >> f.mouse.y >> pressed >> down >>
+          released))
+      continue;
+    f.buttonsPressed = (unsigned char)pressed;
+    f.buttonsDown = (unsigned char)down;
+    f.buttonsReleased = (unsigned char)released;
+
+    ss >> f.keyCount;
+    for (int i = 0; i < f.keyCount && i < 16; i++)
+      ss >> f.keys[i];
+    ss >> f.downCount;
+    for (int i = 0; i < f.downCount && i < 8; i++)
+      ss >> f.downKeys[i];
+    ss >> f.charCount;
+    for (int i = 0; i < f.charCount && i < 16; i++)
+      ss >> f.chars[i];
+    ss >> f.wheel >> f.eventCount;
+    if (!ss || f.keyCount > 16 || f.downCount > 8 || f.charCount > 16 ||
+        f.eventCount < 0 || f.eventCount > 16)
+      continue;
+    clock += f.frameTime;
+    f.time = clock;
+
+    for (int i = 0; i < f.eventCount; i++) {
+      InputEvent &e = f.events[i];
+      int type = 0;
+      double age = 0.0;
+      ss >> type >> e.button >> e.position.x >> e.position.y >> age;
+      e.type = (InputEventType)type;
+      e.time = f.time - age;
+    }
+    if (!ss)
+      continue;
+    frames.push_back(f);
+  }
+  return !frames.empty();
+}
+
+bool TraceInput::ReplaySeed(uint32_t &seed) {
+  if (seedPosition >= seeds.size())
+    return false;
+  seed = seeds[seedPosition++];
+  return true;
+}
+
+bool TraceInput::Poll(FrameInput &next) {
+  if (position >= frames.size())
+    return false;
+  next = frames[position++];
+  return true;
+}
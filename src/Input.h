@@ -0,0 +1,131 @@
+#pragma once
+#include "SpscQueue.h"
+#include "raylib.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+enum class InputEventType : unsigned char { MOUSE_PRESSED, MOUSE_RELEASED };
+
+// A mouse button change stamped when the platform delivered it, rather than
+// when the next frame sampled the button state.
+struct InputEvent {
+  double time = 0.0; // On the input clock
+  Vector2 position = {0, 0};
+  InputEventType type = InputEventType::MOUSE_PRESSED;
+  int button = 0;
+};
+
+// Everything Game and UI read from the keyboard and mouse in one frame.
+// Fixed-size so capturing a frame never allocates.
+struct FrameInput {
+  double time = 0.0; // When the frame was captured, on the input clock
+  float frameTime = 0.0f;
+  Vector2 mouse = {0, 0};
+  unsigned char buttonsPressed = 0; // Bit per raylib mouse button
+  unsigned char buttonsDown = 0;
+  unsigned char buttonsReleased = 0;
+  float wheel = 0.0f;
+  int keyCount = 0;
+  int keys[16] = {};
+  int downCount = 0;
+  int downKeys[8] = {};
+  int charCount = 0;
+  int chars[16] = {};
+  int eventCount = 0;
+  InputEvent events[16] = {};
+};
+
+// Source of per-frame input and of the clock game time is measured on, so a
+// recorded trace can stand in for the live window.
+class InputSource {
+public:
+  virtual ~InputSource() = default;
+
+  // Seconds on a monotonic clock; live input and game time use this clock.
+  static double Now();
+
+  // Hooks into the window once it exists.
+  virtual void Attach() {}
+  // Sleeps until `time` on the input clock, waking for input events so they
+  // are stamped as they arrive. Returns immediately for traces.
+  virtual void WaitUntil(double time) { (void)time; }
+
+  // Captures the next frame. Returns false when a trace has run out.
+  bool BeginFrame();
+
+  // Minefields are part of a session: live input writes the seed of each
+  // game it starts into its trace, and a trace hands the seeds back in the
+  // same order so playback lays out the same mines.
+  virtual void RecordSeed(uint32_t seed) { (void)seed; }
+  // Returns false when the game should keep the seed it drew itself.
+  virtual bool ReplaySeed(uint32_t &seed) {
+    (void)seed;
+    return false;
+  }
+
+  Vector2 GetMousePosition() const { return frame.mouse; }
+  bool IsMouseButtonPressed(int button) const;
+  bool IsMouseButtonDown(int button) const;
+  bool IsMouseButtonReleased(int button) const;
+  float GetMouseWheelMove() const { return frame.wheel; }
+  bool IsKeyPressed(int key) const;
+  bool IsKeyDown(int key) const;
+  int GetKeyPressed();
+  int GetCharPressed();
+  float GetFrameTime() const { return frame.frameTime; }
+  double GetTime() const { return frame.time; }
+  // Button events since the previous frame, oldest first.
+  int GetEventCount() const { return frame.eventCount; }
+  const InputEvent &GetEvent(int index) const { return frame.events[index]; }
+
+protected:
+  virtual bool Poll(FrameInput &next) = 0;
+
+private:
+  FrameInput frame;
+  int keyCursor = 0;
+  int charCursor = 0;
+};
+
+// Live input from raylib, optionally written out as a trace. Mouse button
+// events come from a GLFW callback chained in front of raylib's own and reach
+// the game through a lock-free queue.
+class RaylibInput : public InputSource {
+public:
+  explicit RaylibInput(const std::string &tracePath = "");
+  ~RaylibInput() override;
+
+  void Attach() override;
+  void WaitUntil(double time) override;
+  void RecordSeed(uint32_t seed) override;
+  void PushEvent(const InputEvent &event) { events.Push(event); }
+
+protected:
+  bool Poll(FrameInput &next) override;
+
+private:
+  FILE *trace = nullptr;
+  SpscQueue<InputEvent, 64> events;
+  double lastTime = -1.0;
+};
+
+// Replays a trace written by RaylibInput, one line per frame plus a
+// "seed <n>" line after the frame that started each game. Its clock is
+// virtual: the sum of the recorded frame times.
+class TraceInput : public InputSource {
+public:
+  bool Load(const std::string &path);
+  size_t GetFrameCount() const { return frames.size(); }
+  bool ReplaySeed(uint32_t &seed) override;
+
+protected:
+  bool Poll(FrameInput &next) override;
+
+private:
+  std::vector<FrameInput> frames;
+  size_t position = 0;
+  std::vector<uint32_t> seeds;
+  size_t seedPosition = 0;
+};
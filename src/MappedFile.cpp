@@ -0,0 +1,191 @@
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() { Close(); }
+
+#if defined(_WIN32)
+
+bool MappedFile::Open(const std::string &path, size_t size, bool &existed) {
+  Close();
+  existed = false;
+
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0,
+                            nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER current;
+  if (GetFileSizeEx(file, &current) && (size_t)current.QuadPart == size) {
+    existed = true;
+  } else {
+    LARGE_INTEGER target;
+    target.QuadPart = (LONGLONG)size;
+    if (!SetFilePointerEx(file, target, nullptr, FILE_BEGIN) ||
+        !SetEndOfFile(file)) {
+      CloseHandle(file);
+      return false;
+    }
+  }
+
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, 0, 0,
+                                      nullptr);
+  if (mapping == nullptr) {
+    CloseHandle(file);
+    return false;
+  }
+
+  void *view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+  if (view == nullptr) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+
+  fileHandle = file;
+  mappingHandle = mapping;
+  data = static_cast<unsigned char *>(view);
+  this->size = size;
+  return true;
+}
+
+bool MappedFile::OpenReadOnly(const std::string &path) {
+  Close();
+
+  // Another handle may keep appending, as GameHistory's does.
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ,
+                            FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER current;
+  if (!GetFileSizeEx(file, &current) || current.QuadPart == 0) {
+    CloseHandle(file);
+    return false;
+  }
+
+  HANDLE mapping =
+      CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping == nullptr) {
+    CloseHandle(file);
+    return false;
+  }
+
+  void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (view == nullptr) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+
+  fileHandle = file;
+  mappingHandle = mapping;
+  data = static_cast<unsigned char *>(view);
+  size = (size_t)current.QuadPart;
+  return true;
+}
+
+void MappedFile::Close() {
+  if (data != nullptr)
+    UnmapViewOfFile(data);
+  if (mappingHandle != nullptr)
+    CloseHandle(mappingHandle);
+  if (fileHandle != nullptr)
+    CloseHandle(fileHandle);
+  data = nullptr;
+  mappingHandle = nullptr;
+  fileHandle = nullptr;
+  size = 0;
+}
+
+bool MappedFile::Flush() {
+  if (data == nullptr)
+    return false;
+  return FlushViewOfFile(data, size) && FlushFileBuffers(fileHandle);
+}
+
+#else
+
+bool MappedFile::Open(const std::string &path, size_t size, bool &existed) {
+  Close();
+  existed = false;
+
+  int file = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+  if (file < 0)
+    return false;
+
+  struct stat st;
+  if (fstat(file, &st) == 0 && (size_t)st.st_size == size) {
+    existed = true;
+  } else if (ftruncate(file, (off_t)size) != 0) {
+    close(file);
+    return false;
+  }
+
+  void *view =
+      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+  if (view == MAP_FAILED) {
+    close(file);
+    return false;
+  }
+
+  fd = file;
+  data = static_cast<unsigned char *>(view);
+  this->size = size;
+  return true;
+}
+
+bool MappedFile::OpenReadOnly(const std::string &path) {
+  Close();
+
+  int file = open(path.c_str(), O_RDONLY);
+  if (file < 0)
+    return false;
+
+  struct stat st;
+  if (fstat(file, &st) != 0 || st.st_size == 0) {
+    close(file);
+    return false;
+  }
+
+  void *view =
+      mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+  if (view == MAP_FAILED) {
+    close(file);
+    return false;
+  }
+
+  fd = file;
+  data = static_cast<unsigned char *>(view);
+  size = (size_t)st.st_size;
+  return true;
+}
+
+void MappedFile::Close() {
+  if (data != nullptr)
+    munmap(data, size);
+  if (fd >= 0)
+    close(fd);
+  data = nullptr;
+  fd = -1;
+  size = 0;
+}
+
+bool MappedFile::Flush() {
+  if (data == nullptr)
+    return false;
+  return msync(data, size, MS_SYNC) == 0;
+}
+
+#endif
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// Read-write shared mapping of a whole file. Pages are loaded on demand and
+// written back by the OS; Flush forces them to disk.
+class MappedFile {
+public:
+  MappedFile() = default;
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  // Maps `path`, creating or resizing it to `size` bytes. `existed` is set
+  // when the file was already exactly that size, i.e. may hold prior data.
+  bool Open(const std::string &path, size_t size, bool &existed);
+  // Maps an existing file read-only at its current size.
+  bool OpenReadOnly(const std::string &path);
+  void Close();
+  bool Flush();
+
+  bool IsOpen() const { return data != nullptr; }
+  unsigned char *Data() const { return data; }
+  size_t Size() const { return size; }
+
+private:
+  unsigned char *data = nullptr;
+  size_t size = 0;
+#if defined(_WIN32)
+  void *fileHandle = nullptr;
+  void *mappingHandle = nullptr;
+#else
+  int fd = -1;
+#endif
+};
@@ -0,0 +1,288 @@
+#include "Replay.h"
+#include "AllocTracker.h"
+#include <algorithm>
+#include <cstring>
+
+static const unsigned char replayMagic[4] = {'M', 'S', 'R', 'P'};
+static const unsigned char indexMagic[4] = {'M', 'S', 'R', 'I'};
+static const unsigned char replayVersion = 1;
+
+enum : unsigned char { TAG_KEYFRAME = 3, TAG_END = 4 };
+
+static uint32_t ToMilliseconds(float time) {
+  if (time <= 0.0f)
+    return 0;
+  return (uint32_t)(time * 1000.0f + 0.5f);
+}
+
+void ApplyReplayAction(Board &board, ReplayAction action, int x, int y,
+                       bool noGuess) {
+  switch (action) {
+  case ReplayAction::REVEAL: {
+    bool wasFirst = board.IsFirstClick();
+    board.Reveal(x, y);
+    if (wasFirst && !board.IsFirstClick() && noGuess) {
+      AllocScope scope(ALLOC_GENERATE);
+      board.GenerateNoGuess(x, y);
+    }
+    break;
+  }
+  case ReplayAction::FLAG:
+    board.ToggleFlag(x, y);
+    break;
+  case ReplayAction::CHORD:
+    board.Chord(x, y);
+    break;
+  }
+}
+
+ReplayWriter::ReplayWriter() {
+  // Sized for hours of play so recording never allocates mid-game.
+  buffer.reserve(1 << 20);
+  keyframes.reserve(1024);
+}
+
+void ReplayWriter::Begin(const Board &board, bool noGuess) {
+  buffer.clear();
+  keyframes.clear();
+  width = board.GetWidth();
+  lastTimeMs = 0;
+  eventsSinceKeyframe = 0;
+  // Keep keyframes to roughly an eighth of the cell count in event records.
+  keyframeInterval = std::max(64, board.GetWidth() * board.GetHeight() / 8);
+
+  buffer.insert(buffer.end(), replayMagic, replayMagic + sizeof(replayMagic));
+  buffer.push_back(replayVersion);
+  WriteVarint(board.GetSeed());
+  WriteVarint(board.GetWidth());
+  WriteVarint(board.GetHeight());
+  WriteVarint(board.GetTotalMines());
+  buffer.push_back(noGuess ? 1 : 0);
+
+  recording = true;
+  WriteKeyframe(0, board);
+}
+
+void ReplayWriter::Record(ReplayAction action, int x, int y, float time,
+                          const Board &board) {
+  if (!recording)
+    return;
+
+  uint32_t timeMs = std::max(ToMilliseconds(time), lastTimeMs);
+  buffer.push_back((unsigned char)action);
+  WriteVarint(timeMs - lastTimeMs);
+  WriteVarint((uint64_t)y * width + x);
+  lastTimeMs = timeMs;
+
+  if (++eventsSinceKeyframe >= keyframeInterval) {
+    WriteKeyframe(timeMs, board);
+  }
+}
+
+void ReplayWriter::End(float time, ReplayOutcome outcome) {
+  if (!recording)
+    return;
+
+  lastTimeMs = std::max(ToMilliseconds(time), lastTimeMs);
+  buffer.push_back(TAG_END);
+  WriteVarint(lastTimeMs);
+  buffer.push_back((unsigned char)outcome);
+  recording = false;
+}
+
+bool ReplayWriter::Serialize(std::vector<unsigned char> &bytes) {
+  if (recording || buffer.empty())
+    return false;
+
+  size_t indexOffset = buffer.size();
+  WriteVarint(lastTimeMs);
+  WriteVarint(keyframes.size());
+  for (const auto &kf : keyframes) {
+    WriteVarint(kf.timeMs);
+    WriteVarint(kf.offset);
+  }
+  for (int i = 0; i < 4; i++) {
+    buffer.push_back((unsigned char)((indexOffset >> (8 * i)) & 0xff));
+  }
+  buffer.insert(buffer.end(), indexMagic, indexMagic + sizeof(indexMagic));
+
+  // Copied rather than moved so the next game records into the same
+  // reserved buffer.
+  bytes.assign(buffer.begin(), buffer.end());
+  buffer.resize(indexOffset);
+  return true;
+}
+
+void ReplayWriter::WriteVarint(uint64_t value) {
+  while (value >= 0x80) {
+    buffer.push_back((unsigned char)(value | 0x80));
+    value >>= 7;
+  }
+  buffer.push_back((unsigned char)value);
+}
+
+void ReplayWriter::WriteKeyframe(uint32_t timeMs, const Board &board) {
+  keyframes.push_back({timeMs, buffer.size()});
+  buffer.push_back(TAG_KEYFRAME);
+  WriteVarint(timeMs);
+  size_t start = buffer.size();
+  buffer.resize(start + board.PackedStateSize());
+  board.PackState(buffer.data() + start);
+  eventsSinceKeyframe = 0;
+}
+
+bool ReplayReader::Open(const std::string &path) {
+  Close();
+  if (!file.OpenReadOnly(path))
+    return false;
+
+  data = file.Data();
+  size_t size = file.Size();
+  size_t headerSize = sizeof(replayMagic) + 1;
+  if (size < headerSize + 8 ||
+      std::memcmp(data, replayMagic, sizeof(replayMagic)) != 0 ||
+      data[sizeof(replayMagic)] != replayVersion ||
+      std::memcmp(data + size - 4, indexMagic, sizeof(indexMagic)) != 0) {
+    Close();
+    return false;
+  }
+
+  size_t indexOffset = 0;
+  for (int i = 0; i < 4; i++) {
+    indexOffset |= (size_t)data[size - 8 + i] << (8 * i);
+  }
+  if (indexOffset >= size - 8) {
+    Close();
+    return false;
+  }
+
+  size_t pos = headerSize;
+  uint64_t values[4];
+  for (auto &value : values) {
+    if (!ReadVarint(pos, indexOffset, value)) {
+      Close();
+      return false;
+    }
+  }
+  // The same bounds the game puts on --size and --mines; more mines than
+  // fit around the 3x3 safe area could never be placed.
+  if (values[1] < 4 || values[2] < 4 || values[1] > Board::maxSide ||
+      values[2] > Board::maxSide || values[3] < 1 ||
+      values[3] > values[1] * values[2] - 9) {
+    Close();
+    return false;
+  }
+  seed = (uint32_t)values[0];
+  width = (int)values[1];
+  height = (int)values[2];
+  mines = (int)values[3];
+  noGuess = pos < indexOffset && data[pos++] != 0;
+  eventsBegin = pos;
+  eventsEnd = indexOffset;
+
+  pos = indexOffset;
+  uint64_t duration = 0, count = 0;
+  if (!ReadVarint(pos, size - 8, duration) ||
+      !ReadVarint(pos, size - 8, count) || count == 0) {
+    Close();
+    return false;
+  }
+  // Every keyframe entry takes at least two bytes, which bounds a count
+  // read from a damaged file before anything is reserved for it.
+  if (count > (size - 8 - pos) / 2) {
+    Close();
+    return false;
+  }
+  durationMs = (uint32_t)duration;
+  keyframes.reserve((size_t)count);
+  for (uint64_t i = 0; i < count; i++) {
+    uint64_t timeMs = 0, offset = 0;
+    if (!ReadVarint(pos, size - 8, timeMs) ||
+        !ReadVarint(pos, size - 8, offset) || offset < eventsBegin ||
+        offset >= eventsEnd) {
+      Close();
+      return false;
+    }
+    keyframes.push_back({(uint32_t)timeMs, offset});
+  }
+
+  cursor = eventsBegin;
+  positionMs = 0;
+  return true;
+}
+
+void ReplayReader::Close() {
+  file.Close();
+  data = nullptr;
+  keyframes.clear();
+  eventsBegin = eventsEnd = cursor = 0;
+  positionMs = durationMs = 0;
+}
+
+void ReplayReader::Seek(Board &board, uint32_t timeMs) {
+  if (!IsOpen() || board.GetWidth() != width || board.GetHeight() != height)
+    return;
+
+  auto it = std::upper_bound(
+      keyframes.begin(), keyframes.end(), timeMs,
+      [](uint32_t t, const Keyframe &kf) { return t < kf.timeMs; });
+  const Keyframe &kf = (it == keyframes.begin()) ? keyframes.front() : *(it - 1);
+
+  size_t pos = (size_t)kf.offset + 1;
+  uint64_t keyframeMs = 0;
+  if (!ReadVarint(pos, eventsEnd, keyframeMs) ||
+      pos + board.PackedStateSize() > eventsEnd)
+    return;
+
+  board.SetSeed(seed);
+  board.UnpackState(data + pos);
+  cursor = pos + board.PackedStateSize();
+  positionMs = (uint32_t)keyframeMs;
+  Advance(board, timeMs);
+}
+
+void ReplayReader::Advance(Board &board, uint32_t timeMs) {
+  if (!IsOpen() || board.GetWidth() != width || board.GetHeight() != height)
+    return;
+
+  uint32_t recordMs = positionMs;
+  while (cursor < eventsEnd) {
+    size_t pos = cursor;
+    unsigned char tag = data[pos++];
+    uint64_t time = 0;
+    if (!ReadVarint(pos, eventsEnd, time))
+      break;
+
+    if (tag == TAG_KEYFRAME) {
+      if (time > timeMs)
+        break;
+      recordMs = (uint32_t)time;
+      pos += board.PackedStateSize();
+    } else if (tag == TAG_END) {
+      if (time > timeMs)
+        break;
+      recordMs = (uint32_t)time;
+      pos += 1;
+    } else {
+      uint64_t cell = 0;
+      if (recordMs + time > timeMs || !ReadVarint(pos, eventsEnd, cell))
+        break;
+      recordMs += (uint32_t)time;
+      ApplyReplayAction(board, (ReplayAction)tag, (int)(cell % width),
+                        (int)(cell / width), noGuess);
+    }
+    cursor = pos;
+    positionMs = recordMs;
+  }
+}
+
+bool ReplayReader::ReadVarint(size_t &pos, size_t end, uint64_t &value) const {
+  value = 0;
+  for (int shift = 0; pos < end && shift < 64; shift += 7) {
+    unsigned char byte = data[pos++];
+    value |= (uint64_t)(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0)
+      return true;
+  }
+  return false;
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include "Board.h"
+#include "MappedFile.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class ReplayAction : uint8_t { REVEAL = 0, FLAG = 1, CHORD = 2 };
+
+enum class ReplayOutcome : uint8_t { INCOMPLETE = 0, WON = 1, LOST = 2 };
+
+// Applies one move the way Game does, including no-guess board generation on
+// the first reveal. Shared by live play and playback so both stay identical.
+void ApplyReplayAction(Board &board, ReplayAction action, int x, int y,
+                       bool noGuess);
+
+// Replay stream layout (all integers are LEB128 varints unless noted):
+//   "MSRP" u8 version, seed, width, height, mines, u8 noGuess
+//   records: u8 tag
+//     REVEAL/FLAG/CHORD: delta ms since previous record, cell index
+//     KEYFRAME:          absolute ms, Board::PackState bytes
+//     END:               absolute ms, u8 outcome
+//   index: keyframe count, then (absolute ms, byte offset) per keyframe
+//   footer: u32 little-endian offset of the index, "MSRI"
+class ReplayWriter {
+public:
+  ReplayWriter();
+
+  void Begin(const Board &board, bool noGuess);
+  void Record(ReplayAction action, int x, int y, float time,
+              const Board &board);
+  void End(float time, ReplayOutcome outcome);
+  // The finished replay as file bytes, index and footer included.
+  bool Serialize(std::vector<unsigned char> &bytes);
+  bool IsRecording() const { return recording; }
+
+private:
+  struct Keyframe {
+    uint32_t timeMs;
+    uint64_t offset;
+  };
+
+  std::vector<unsigned char> buffer;
+  std::vector<Keyframe> keyframes;
+  bool recording = false;
+  int width = 0;
+  uint32_t lastTimeMs = 0;
+  int eventsSinceKeyframe = 0;
+  int keyframeInterval = 64;
+
+  void WriteVarint(uint64_t value);
+  void WriteKeyframe(uint32_t timeMs, const Board &board);
+};
+
+class ReplayReader {
+public:
+  bool Open(const std::string &path);
+  void Close();
+  bool IsOpen() const { return file.IsOpen(); }
+
+  uint32_t GetSeed() const { return seed; }
+  int GetWidth() const { return width; }
+  int GetHeight() const { return height; }
+  int GetMines() const { return mines; }
+  bool IsNoGuess() const { return noGuess; }
+  uint32_t GetDurationMs() const { return durationMs; }
+
+  // Restores `board` to its state at `timeMs` from the nearest keyframe at or
+  // before it, then applies the remaining actions.
+  void Seek(Board &board, uint32_t timeMs);
+  // Applies actions from the current position up to `timeMs`.
+  void Advance(Board &board, uint32_t timeMs);
+  uint32_t GetPositionMs() const { return positionMs; }
+
+private:
+  struct Keyframe {
+    uint32_t timeMs;
+    uint64_t offset;
+  };
+
+  MappedFile file;
+  const unsigned char *data = nullptr;
+  size_t eventsBegin = 0;
+  size_t eventsEnd = 0;
+  size_t cursor = 0;
+  uint32_t positionMs = 0;
+  uint32_t durationMs = 0;
+  std::vector<Keyframe> keyframes;
+
+  uint32_t seed = 0;
+  int width = 0;
+  int height = 0;
+  int mines = 0;
+  bool noGuess = false;
+
+  bool ReadVarint(size_t &pos, size_t end, uint64_t &value) const;
+};
@@ -0,0 +1,145 @@
+#include "SpriteAtlas.h"
+#include <cmath>
+
+SpriteAtlas::~SpriteAtlas() { Unload(); }
+
+void SpriteAtlas::Build(int cellSize, const Texture2D *mineIcon) {
+  Unload();
+  this->cellSize = cellSize;
+  this->mineIcon = mineIcon;
+
+  RenderTexture2D strip = LoadRenderTexture(VISUAL_COUNT * cellSize, cellSize);
+  BeginTextureMode(strip);
+  ClearBackground(Color{33, 37, 43, 255});
+  for (int v = 0; v < VISUAL_COUNT; v++) {
+    DrawCellVisual((CellVisual)v, v * cellSize, 0);
+  }
+  EndTextureMode();
+
+  // Read back and flip so the atlas is stored top-down like a loaded image.
+  Image image = LoadImageFromTexture(strip.texture);
+  ImageFlipVertical(&image);
+  texture = LoadTextureFromImage(image);
+  UnloadImage(image);
+  UnloadRenderTexture(strip);
+  SetTextureFilter(texture, TEXTURE_FILTER_POINT);
+  built = true;
+}
+
+void SpriteAtlas::Unload() {
+  if (built)
+    UnloadTexture(texture);
+  built = false;
+}
+
+void SpriteAtlas::DrawCellVisual(CellVisual visual, int posX, int posY) {
+  float roundness = 0.2f;
+  int segments = 8;
+  Rectangle rect = {(float)posX + 2, (float)posY + 2, (float)cellSize - 4,
+                    (float)cellSize - 4};
+
+  if (visual == VISUAL_HIDDEN || visual == VISUAL_HIDDEN_FLAGGED) {
+    DrawRectangleRounded(rect, roundness, segments, Color{45, 50, 60, 255});
+    DrawRectangleRoundedLines(rect, roundness, segments, 1.0f,
+                              Color{60, 65, 75, 255});
+
+    if (visual == VISUAL_HIDDEN_FLAGGED) {
+      DrawFlag(posX + cellSize / 2, posY + cellSize / 2, cellSize / 2);
+    }
+    return;
+  }
+
+  if (visual == VISUAL_MINE_EXPLODED) {
+    DrawRectangleRounded(rect, roundness, segments, Color{255, 50, 50, 220});
+  } else {
+    DrawRectangleRounded(rect, roundness, segments, Color{28, 32, 38, 255});
+  }
+
+  // Sizes below were tuned for 32px cells and scale from there.
+  float scale = cellSize / 32.0f;
+  if (visual >= VISUAL_MINE) {
+    DrawMine(posX + cellSize / 2, posY + cellSize / 2, cellSize / 2);
+    if (visual == VISUAL_MINE_FLAGGED) {
+      float inset = 5.0f * scale;
+      float left = posX + inset, right = posX + cellSize - inset;
+      float top = posY + inset, bottom = posY + cellSize - inset;
+      DrawLineEx({left, top}, {right, bottom}, 2.0f * scale, GREEN);
+      DrawLineEx({right, top}, {left, bottom}, 2.0f * scale, GREEN);
+    }
+  } else if (visual >= VISUAL_NUMBER_1) {
+    int number = visual - VISUAL_NUMBER_1 + 1;
+    const char text[2] = {(char)('0' + number), '\0'};
+    int fontSize = (int)(20 * scale);
+    int width = MeasureText(text, fontSize);
+    DrawText(text, posX + (cellSize - width) / 2, posY + (int)(6 * scale),
+             fontSize, GetNumberColor(number));
+  }
+}
+
+void SpriteAtlas::DrawMine(int cx, int cy, int size) {
+  if (mineIcon != nullptr) {
+    Rectangle source = {0.0f, 0.0f, (float)mineIcon->width,
+                        (float)mineIcon->height};
+    Rectangle dest = {(float)cx, (float)cy, (float)size, (float)size};
+    Vector2 origin = {(float)size / 2.0f, (float)size / 2.0f};
+    DrawTexturePro(*mineIcon, source, dest, origin, 0.0f, WHITE);
+  } else {
+    DrawCircle((float)cx, (float)cy, size / 2.5f, BLACK);
+    float spikeLen = size / 2.0f;
+    for (int i = 0; i < 8; i++) {
+      float angle = i * PI / 4.0f;
+      DrawLineEx({(float)cx, (float)cy},
+                 {(float)cx + cosf(angle) * spikeLen,
+                  (float)cy + sinf(angle) * spikeLen},
+                 size / 8.0f, BLACK);
+    }
+    DrawCircle((float)cx - size / 7.0f, (float)cy - size / 7.0f, size / 10.0f,
+               GRAY);
+  }
+}
+
+void SpriteAtlas::DrawFlag(int cx, int cy, int size) {
+  float baseW = size * 0.7f;
+  float poleH = size * 1.1f;
+  float thick = size / 4.0f;
+
+  DrawRectangleRec({(float)cx - baseW / 2.0f, (float)cy + poleH / 2.0f - thick,
+                    baseW, thick},
+                   BLACK);
+  DrawRectangleRec({(float)cx - baseW / 4.0f,
+                    (float)cy + poleH / 2.0f - 2.0f * thick, baseW / 2.0f,
+                    thick},
+                   BLACK);
+
+  DrawRectangleRec(
+      {(float)cx - thick / 2.0f, (float)cy - poleH / 2.0f, thick, poleH},
+      BLACK);
+
+  Vector2 top = {(float)cx, (float)cy - poleH / 2};
+  Vector2 bottom = {(float)cx, (float)cy - poleH / 2 + size * 0.5f};
+  Vector2 tip = {(float)cx - size * 0.5f, (float)cy - poleH / 2 + size * 0.25f};
+  DrawTriangle(bottom, top, tip, RED);
+}
+
+Color SpriteAtlas::GetNumberColor(int number) {
+  switch (number) {
+  case 1:
+    return Color{99, 151, 255, 255};
+  case 2:
+    return Color{80, 250, 123, 255};
+  case 3:
+    return Color{255, 85, 85, 255};
+  case 4:
+    return Color{189, 147, 249, 255};
+  case 5:
+    return Color{255, 184, 108, 255};
+  case 6:
+    return Color{139, 233, 253, 255};
+  case 7:
+    return Color{255, 121, 198, 255};
+  case 8:
+    return Color{241, 250, 140, 255};
+  default:
+    return RAYWHITE;
+  }
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "CellVisual.h"
+#include "raylib.h"
+
+// Every cell visual (tiles, flags, mines, numbers 1-8) drawn once into a
+// single texture, laid out as a horizontal strip of cellSize squares, so a
+// cell is one textured quad that raylib can batch with its neighbours.
+class SpriteAtlas {
+public:
+  SpriteAtlas() = default;
+  ~SpriteAtlas();
+  SpriteAtlas(const SpriteAtlas &) = delete;
+  SpriteAtlas &operator=(const SpriteAtlas &) = delete;
+
+  // (Re)bakes all sprites at `cellSize` pixels. Needs a GL context.
+  // `mineIcon` replaces the vector mine when non-null.
+  void Build(int cellSize, const Texture2D *mineIcon);
+  void Unload();
+
+  bool IsBuilt() const { return built; }
+  int GetCellSize() const { return cellSize; }
+  const Texture2D &GetTexture() const { return texture; }
+  Rectangle GetSource(CellVisual visual) const {
+    return {(float)(visual * cellSize), 0.0f, (float)cellSize,
+            (float)cellSize};
+  }
+  void Draw(CellVisual visual, float x, float y) const {
+    DrawTextureRec(texture, GetSource(visual), {x, y}, WHITE);
+  }
+
+private:
+  Texture2D texture;
+  int cellSize = 0;
+  bool built = false;
+  const Texture2D *mineIcon = nullptr;
+
+  void DrawCellVisual(CellVisual visual, int posX, int posY);
+  void DrawMine(int cx, int cy, int size);
+  void DrawFlag(int cx, int cy, int size);
+  static Color GetNumberColor(int number);
+};
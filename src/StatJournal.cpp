@@ -0,0 +1,438 @@
+#include "StatJournal.h"
+#include "AllocTracker.h"
+#include "Crc32.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+const char journalMagic[4] = {'M', 'S', 'J', '3'};
+const StatsKey legacyStatsKey = {30, 16, 99, false};
+
+// Binary snapshot, all integers little-endian:
+//
+//   header   magic "MSST", u16 version, u16 section count, u32 generation,
+//            u32 CRC-32 of every byte after the header
+//   section  u16 tag, u16 reserved, u32 payload length, payload
+//
+// Readers skip sections with tags they do not know, so a section can be
+// added without bumping the version. There is one CONFIG section per board
+// configuration.
+static const char snapshotMagic[4] = {'M', 'S', 'S', 'T'};
+static const uint16_t snapshotVersion = 2;
+static const size_t snapshotHeaderSize = 16;
+static const size_t sectionHeaderSize = 8;
+
+enum : uint16_t {
+  SECTION_SETTINGS = 4, // u8 no-guess mode
+  SECTION_CONFIG = 5,   // key, counters, win times, high scores
+};
+
+static const size_t keySize = 3 * 4 + 1;
+static const size_t countersSize = 5 * 4;
+static const size_t winTimesSize = 4 + 4 + 4 + 8 + 4 +
+                                   TimeStats::binCount * 4 +
+                                   TimeStats::recentCount * 4;
+
+namespace {
+
+class SnapshotWriter {
+public:
+  void U8(uint8_t v) { bytes.push_back(v); }
+  void U16(uint16_t v) { Put(v, 2); }
+  void U32(uint32_t v) { Put(v, 4); }
+  void I32(int32_t v) { Put((uint32_t)v, 4); }
+  void F32(float v) {
+    uint32_t bits;
+    std::memcpy(&bits, &v, 4);
+    Put(bits, 4);
+  }
+  void F64(double v) {
+    uint64_t bits;
+    std::memcpy(&bits, &v, 8);
+    Put(bits, 8);
+  }
+  void Bytes(const void *data, size_t size) {
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    bytes.insert(bytes.end(), p, p + size);
+  }
+
+  // Sections are written in place; End fills in the length.
+  void BeginSection(uint16_t tag) {
+    U16(tag);
+    U16(0);
+    sectionStart = bytes.size();
+    U32(0);
+    sections++;
+  }
+  void EndSection() {
+    uint32_t length = (uint32_t)(bytes.size() - sectionStart - 4);
+    for (int i = 0; i < 4; i++)
+      bytes[sectionStart + i] = (unsigned char)(length >> (8 * i));
+  }
+
+  std::vector<unsigned char> bytes;
+  uint16_t sections = 0;
+
+private:
+  void Put(uint64_t v, int size) {
+    for (int i = 0; i < size; i++)
+      bytes.push_back((unsigned char)(v >> (8 * i)));
+  }
+
+  size_t sectionStart = 0;
+};
+
+// Bounds-checked cursor over a snapshot. Reading past the end sets `failed`
+// and returns zeros, so callers check once after a whole section.
+class SnapshotReader {
+public:
+  SnapshotReader(const unsigned char *data, size_t size)
+      : data(data), size(size) {}
+
+  uint8_t U8() { return (uint8_t)Get(1); }
+  uint16_t U16() { return (uint16_t)Get(2); }
+  uint32_t U32() { return (uint32_t)Get(4); }
+  int32_t I32() { return (int32_t)(uint32_t)Get(4); }
+  float F32() {
+    uint32_t bits = (uint32_t)Get(4);
+    float v;
+    std::memcpy(&v, &bits, 4);
+    return v;
+  }
+  double F64() {
+    uint64_t bits = Get(8);
+    double v;
+    std::memcpy(&v, &bits, 8);
+    return v;
+  }
+  const unsigned char *Bytes(size_t count) {
+    if (count > size - offset) {
+      failed = true;
+      offset = size;
+      return nullptr;
+    }
+    const unsigned char *p = data + offset;
+    offset += count;
+    return p;
+  }
+
+  size_t Remaining() const { return size - offset; }
+  bool failed = false;
+
+private:
+  uint64_t Get(int count) {
+    const unsigned char *p = Bytes(count);
+    uint64_t v = 0;
+    for (int i = 0; p != nullptr && i < count; i++)
+      v |= (uint64_t)p[i] << (8 * i);
+    return v;
+  }
+
+  const unsigned char *data;
+  size_t size;
+  size_t offset = 0;
+};
+
+} // namespace
+
+JournalRecord MakeJournalRecord(JournalEvent type) {
+  JournalRecord record;
+  std::memset(&record, 0, sizeof(record));
+  record.type = (uint8_t)type;
+  return record;
+}
+
+JournalRecord MakeJournalRecord(JournalEvent type, const StatsKey &key) {
+  JournalRecord record = MakeJournalRecord(type);
+  record.width = key.width;
+  record.height = key.height;
+  record.mines = key.mines;
+  record.noGuess = key.noGuess ? 1 : 0;
+  return record;
+}
+
+uint32_t JournalRecordChecksum(const JournalRecord &record) {
+  return Crc32(&record, offsetof(JournalRecord, checksum));
+}
+
+static StatsKey KeyOf(const JournalRecord &record) {
+  return {record.width, record.height, record.mines, record.noGuess != 0};
+}
+
+void ApplyJournalRecord(StatsData &data, const JournalRecord &record) {
+  AllocScope scope(ALLOC_STORAGE);
+  JournalEvent type = (JournalEvent)record.type;
+  if (type == JournalEvent::NO_GUESS) {
+    data.noGuessMode = (record.flags & 1) != 0;
+    return;
+  }
+
+  ConfigStats &stats = data.configs[KeyOf(record)];
+  switch (type) {
+  case JournalEvent::START:
+    stats.gamesStarted++;
+    break;
+  case JournalEvent::INCOMPLETE:
+    stats.gamesIncomplete++;
+    break;
+  case JournalEvent::GAME:
+    if (record.flags & 1) {
+      stats.gamesWon++;
+      stats.winTimes.Add(record.time);
+    } else if (record.flags & 2) {
+      stats.gamesLost++;
+    }
+    stats.totalMinesFlagged += record.value;
+    break;
+  case JournalEvent::HIGH_SCORE: {
+    char name[sizeof(record.name) + 1] = {};
+    std::memcpy(name, record.name, sizeof(record.name));
+    HighScore score = {name, record.time};
+    auto at = std::upper_bound(
+        stats.highScores.begin(), stats.highScores.end(), score,
+        [](const HighScore &a, const HighScore &b) { return a.time < b.time; });
+    stats.highScores.insert(at, score);
+    if (stats.highScores.size() > 10) {
+      stats.highScores.resize(10);
+    }
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+static void WriteCounters(SnapshotWriter &out, const ConfigStats &stats) {
+  out.I32(stats.gamesStarted);
+  out.I32(stats.gamesWon);
+  out.I32(stats.gamesLost);
+  out.I32(stats.gamesIncomplete);
+  out.I32(stats.totalMinesFlagged);
+}
+
+static void WriteWinTimes(SnapshotWriter &out, const TimeStats &times) {
+  out.I32(times.count);
+  out.F32(times.min);
+  out.F32(times.max);
+  out.F64(times.sum);
+  out.I32(times.recentHead);
+  for (uint32_t n : times.bins)
+    out.U32(n);
+  for (float t : times.recent)
+    out.F32(t);
+}
+
+static void WriteHighScores(SnapshotWriter &out,
+                            const std::vector<HighScore> &scores) {
+  out.U32((uint32_t)scores.size());
+  for (const auto &hs : scores) {
+    size_t length = std::min(hs.name.size(), (size_t)0xffff);
+    out.U16((uint16_t)length);
+    out.Bytes(hs.name.data(), length);
+    out.F32(hs.time);
+  }
+}
+
+static void ReadCounters(SnapshotReader &in, ConfigStats &stats) {
+  stats.gamesStarted = in.I32();
+  stats.gamesWon = in.I32();
+  stats.gamesLost = in.I32();
+  stats.gamesIncomplete = in.I32();
+  stats.totalMinesFlagged = in.I32();
+}
+
+static void ReadWinTimes(SnapshotReader &in, TimeStats &times) {
+  times.count = in.I32();
+  times.min = in.F32();
+  times.max = in.F32();
+  times.sum = in.F64();
+  times.recentHead = in.I32();
+  for (uint32_t &n : times.bins)
+    n = in.U32();
+  for (float &t : times.recent)
+    t = in.F32();
+  if (times.recentHead < 0 || times.recentHead >= TimeStats::recentCount)
+    times.recentHead = 0;
+  times.Refresh();
+}
+
+static void ReadHighScores(SnapshotReader &in,
+                           std::vector<HighScore> &scores) {
+  uint32_t count = in.U32();
+  // Each score takes at least six bytes, which bounds the reserve.
+  scores.reserve(std::min<size_t>(count, in.Remaining() / 6));
+  for (uint32_t i = 0; i < count && !in.failed; i++) {
+    uint16_t nameLength = in.U16();
+    const unsigned char *name = in.Bytes(nameLength);
+    float time = in.F32();
+    if (!in.failed)
+      scores.push_back({std::string((const char *)name, nameLength), time});
+  }
+}
+
+bool WriteStatsSnapshot(const std::string &path, const StatsData &data,
+                        uint32_t generation) {
+  AllocScope scope(ALLOC_STORAGE);
+  SnapshotWriter out;
+  out.bytes.reserve(snapshotHeaderSize + sectionHeaderSize + 1 +
+                    data.configs.size() *
+                        (sectionHeaderSize + keySize + countersSize +
+                         winTimesSize + 4 + 10 * 32));
+  out.bytes.resize(snapshotHeaderSize);
+
+  out.BeginSection(SECTION_SETTINGS);
+  out.U8(data.noGuessMode ? 1 : 0);
+  out.EndSection();
+
+  for (const auto &entry : data.configs) {
+    const StatsKey &key = entry.first;
+    out.BeginSection(SECTION_CONFIG);
+    out.I32(key.width);
+    out.I32(key.height);
+    out.I32(key.mines);
+    out.U8(key.noGuess ? 1 : 0);
+    WriteCounters(out, entry.second);
+    WriteWinTimes(out, entry.second.winTimes);
+    WriteHighScores(out, entry.second.highScores);
+    out.EndSection();
+  }
+
+  SnapshotWriter header;
+  header.Bytes(snapshotMagic, sizeof(snapshotMagic));
+  header.U16(snapshotVersion);
+  header.U16(out.sections);
+  header.U32(generation);
+  header.U32(Crc32(out.bytes.data() + snapshotHeaderSize,
+                   out.bytes.size() - snapshotHeaderSize));
+  std::copy(header.bytes.begin(), header.bytes.end(), out.bytes.begin());
+
+  std::string temp = path + ".tmp";
+  {
+    std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+      return false;
+    file.write(reinterpret_cast<const char *>(out.bytes.data()),
+               (std::streamsize)out.bytes.size());
+    file.flush();
+    if (!file.good())
+      return false;
+  }
+
+  // Windows cannot rename onto an existing file.
+#if defined(_WIN32)
+  std::remove(path.c_str());
+#endif
+  return std::rename(temp.c_str(), path.c_str()) == 0;
+}
+
+static bool ReadBinarySnapshot(const unsigned char *bytes, size_t size,
+                               StatsData &data, uint32_t &generation) {
+  SnapshotReader in(bytes, size);
+  in.Bytes(sizeof(snapshotMagic));
+  uint16_t version = in.U16();
+  uint16_t sections = in.U16();
+  uint32_t fileGeneration = in.U32();
+  uint32_t crc = in.U32();
+  if (in.failed || version != snapshotVersion ||
+      crc != Crc32(bytes + snapshotHeaderSize, size - snapshotHeaderSize))
+    return false;
+
+  for (int s = 0; s < sections; s++) {
+    uint16_t tag = in.U16();
+    in.U16();
+    uint32_t length = in.U32();
+    const unsigned char *payload = in.Bytes(length);
+    if (in.failed)
+      return false;
+    SnapshotReader section(payload, length);
+
+    switch (tag) {
+    case SECTION_SETTINGS:
+      data.noGuessMode = section.U8() != 0;
+      break;
+    case SECTION_CONFIG: {
+      StatsKey key;
+      key.width = section.I32();
+      key.height = section.I32();
+      key.mines = section.I32();
+      key.noGuess = section.U8() != 0;
+      ConfigStats &stats = data.configs[key];
+      ReadCounters(section, stats);
+      ReadWinTimes(section, stats.winTimes);
+      ReadHighScores(section, stats.highScores);
+      break;
+    }
+    default:
+      break;
+    }
+    if (section.failed)
+      return false;
+  }
+
+  generation = fileGeneration;
+  return true;
+}
+
+// The original whitespace-separated text format, holding the stats of the
+// legacy configuration and every win time. Names were written with `<<`, so
+// a name with a space shifts every field after it; such files read as far as
+// they parse.
+static void ReadLegacySnapshot(const unsigned char *bytes, size_t size,
+                               StatsData &data) {
+  std::istringstream in(std::string((const char *)bytes, size));
+  ConfigStats &stats = data.configs[legacyStatsKey];
+  int winCount = 0;
+  int hsCount = 0;
+  in >> stats.gamesStarted >> stats.gamesWon >> stats.gamesLost >>
+      stats.gamesIncomplete >> stats.totalMinesFlagged >> data.noGuessMode >>
+      winCount >> hsCount;
+
+  for (int i = 0; i < winCount; i++) {
+    float t;
+    if (!(in >> t))
+      break;
+    stats.winTimes.Add(t);
+  }
+
+  for (int i = 0; i < hsCount; i++) {
+    std::string name;
+    float time;
+    if (!(in >> name >> time))
+      break;
+    stats.highScores.push_back({name, time});
+  }
+}
+
+bool ReadStatsSnapshot(const std::string &path, StatsData &data,
+                       uint32_t &generation) {
+  AllocScope scope(ALLOC_STORAGE);
+  data = StatsData();
+  generation = 0;
+  MappedFile file;
+  if (!file.OpenReadOnly(path))
+    return true;
+
+  const unsigned char *bytes = file.Data();
+  size_t size = file.Size();
+  if (size < sizeof(snapshotMagic) ||
+      std::memcmp(bytes, snapshotMagic, sizeof(snapshotMagic)) != 0) {
+    ReadLegacySnapshot(bytes, size, data);
+    return false;
+  }
+  if (ReadBinarySnapshot(bytes, size, data, generation))
+    return true;
+
+  // Set the damaged file aside rather than let the next compaction
+  // overwrite it, and start from empty stats.
+  file.Close();
+  data = StatsData();
+  generation = 0;
+  std::string damaged = path + ".bad";
+  std::remove(damaged.c_str());
+  std::rename(path.c_str(), damaged.c_str());
+  return false;
+}
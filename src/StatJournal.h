@@ -0,0 +1,107 @@
+#pragma once
+#include "TimeStats.h"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+struct HighScore {
+  std::string name;
+  float time;
+};
+
+// Identifies one board configuration. Stats are only ever compared between
+// games of the same key, so times from a beginner board never land on the
+// expert leaderboard.
+struct StatsKey {
+  int32_t width = 30;
+  int32_t height = 16;
+  int32_t mines = 99;
+  bool noGuess = false;
+
+  bool operator<(const StatsKey &other) const {
+    return std::tie(width, height, mines, noGuess) <
+           std::tie(other.width, other.height, other.mines, other.noGuess);
+  }
+  bool operator==(const StatsKey &other) const {
+    return width == other.width && height == other.height &&
+           mines == other.mines && noGuess == other.noGuess;
+  }
+};
+
+struct ConfigStats {
+  int gamesStarted = 0;
+  int gamesWon = 0;
+  int gamesLost = 0;
+  int gamesIncomplete = 0;
+  TimeStats winTimes;
+  std::vector<HighScore> highScores;
+  int totalMinesFlagged = 0;
+};
+
+struct StatsData {
+  std::map<StatsKey, ConfigStats> configs;
+  bool noGuessMode = false;
+};
+
+enum class JournalEvent : uint8_t {
+  START = 1,
+  INCOMPLETE = 2,
+  GAME = 3,       // flags: 1 won, 2 lost; value: mines flagged
+  HIGH_SCORE = 4, // name, time
+  NO_GUESS = 5,   // flags: 1 enabled
+};
+
+// One stats change, written to the journal as-is. Game events carry the
+// configuration they belong to. The checksum covers the bytes before it, so
+// a record torn by a crash is detected on replay.
+struct JournalRecord {
+  uint8_t type;
+  uint8_t flags;
+  uint8_t noGuess;
+  uint8_t reserved;
+  int32_t value;
+  float time;
+  int32_t width;
+  int32_t height;
+  int32_t mines;
+  char name[16];
+  uint32_t reserved2;
+  uint32_t checksum;
+};
+static_assert(sizeof(JournalRecord) == 48, "JournalRecord layout changed");
+
+// Starts every journal. Snapshots and journals carry a generation number,
+// and a journal only applies to the snapshot of the same generation, so a
+// crash between writing a snapshot and resetting the journal cannot apply
+// events twice.
+struct JournalHeader {
+  char magic[4];
+  uint32_t generation;
+  uint32_t recordSize;
+  uint32_t reserved;
+};
+static_assert(sizeof(JournalHeader) == 16, "JournalHeader layout changed");
+
+extern const char journalMagic[4];
+// Stats recorded before configurations were tracked all came from the
+// hardcoded 30x16 board with 99 mines.
+extern const StatsKey legacyStatsKey;
+
+JournalRecord MakeJournalRecord(JournalEvent type);
+JournalRecord MakeJournalRecord(JournalEvent type, const StatsKey &key);
+uint32_t JournalRecordChecksum(const JournalRecord &record);
+// Applies one change to `data`. StatManager and its writer both replay the
+// same records, so the copy the writer snapshots never drifts.
+void ApplyJournalRecord(StatsData &data, const JournalRecord &record);
+
+// Writes `data` to a temporary file and renames it over `path`, so a crash
+// leaves either the old snapshot or the new one.
+bool WriteStatsSnapshot(const std::string &path, const StatsData &data,
+                        uint32_t generation);
+// Reads a snapshot. A missing file reads as empty stats of generation 0.
+// Returns false when the file should be rewritten: it is in the legacy text
+// format, or failed its checksum and was renamed to `path` + ".bad".
+bool ReadStatsSnapshot(const std::string &path, StatsData &data,
+                       uint32_t &generation);
@@ -1,13 +1,11 @@
 #include "StatManager.h"
-#include <fstream>
-#include <iostream>
-
+#include "Trace.h"
 #include <algorithm>
-#if defined(PLATFORM_WEB)
-#include <emscripten/emscripten.h>
-#endif
+#include <cstdio>
+#include <cstring>
 
-StatManager::StatManager(const std::string &filename) : baseFilename(filename) {
+StatManager::StatManager(const std::string &filename)
+    : baseFilename(filename), persistent(!filename.empty()) {
 #if defined(PLATFORM_WEB)
   this->filename = "/persistent/" + filename;
 #else
@@ -16,53 +14,84 @@ StatManager::StatManager(const std::string &filename) : baseFilename(filename) {
   Load();
 }
 
+StatManager::~StatManager() { writer.Stop(); }
+
 void StatManager::RecordStart() {
-  data.gamesStarted++;
-  Save();
+  JournalRecord record = MakeJournalRecord(JournalEvent::START, config);
+  Append(record);
 }
 
 void StatManager::RecordIncomplete() {
-  data.gamesIncomplete++;
-  Save();
+  JournalRecord record = MakeJournalRecord(JournalEvent::INCOMPLETE, config);
+  Append(record);
 }
 
 void StatManager::RecordGame(bool won, bool lost, float time,
                              int minesFlagged) {
-  if (won) {
-    data.gamesWon++;
-    data.winTimes.push_back(time);
-  } else if (lost) {
-    data.gamesLost++;
-  }
-  data.totalMinesFlagged += minesFlagged;
-  Save();
+  JournalRecord record = MakeJournalRecord(JournalEvent::GAME, config);
+  record.flags = (won ? 1 : 0) | (lost ? 2 : 0);
+  record.value = minesFlagged;
+  record.time = time;
+  Append(record);
 }
 
 void StatManager::AddHighScore(const std::string &name, float time) {
-  data.highScores.push_back({name, time});
-  std::sort(
-      data.highScores.begin(), data.highScores.end(),
-      [](const HighScore &a, const HighScore &b) { return a.time < b.time; });
-  if (data.highScores.size() > 10) {
-    data.highScores.resize(10);
-  }
-  Save();
+  JournalRecord record = MakeJournalRecord(JournalEvent::HIGH_SCORE, config);
+  std::strncpy(record.name, name.c_str(), sizeof(record.name) - 1);
+  record.time = time;
+  Append(record);
+}
+
+void StatManager::RecordHistory(const GameRecord &record) {
+  if (persistent)
+    writer.PushHistory(record);
+}
+
+void StatManager::SaveReplay(const std::string &path,
+                             std::vector<unsigned char> bytes) {
+  if (persistent)
+    writer.PushReplay(path, std::move(bytes));
+}
+
+const GameHistory &StatManager::GetHistory() {
+  writer.SyncHistory(history);
+  return history;
+}
+
+void StatManager::SetNoGuessMode(bool enabled) {
+  JournalRecord record = MakeJournalRecord(JournalEvent::NO_GUESS);
+  record.flags = enabled ? 1 : 0;
+  Append(record);
+}
+
+void StatManager::Append(const JournalRecord &record) {
+  ApplyJournalRecord(data, record);
+  if (persistent)
+    writer.Push(record);
+}
+
+const ConfigStats &StatManager::GetConfigStats() const {
+  static const ConfigStats empty;
+  auto it = data.configs.find(config);
+  return it != data.configs.end() ? it->second : empty;
 }
 
 bool StatManager::IsNewHighScore(float time) const {
-  if (data.highScores.size() < 10)
+  const std::vector<HighScore> &highScores = GetHighScores();
+  if (highScores.size() < 10)
     return true;
-  return time < data.highScores.back().time;
+  return time < highScores.back().time;
 }
 
 int StatManager::GetRankForTime(float time) const {
-  for (int i = 0; i < (int)data.highScores.size(); i++) {
-    if (time < data.highScores[i].time) {
+  const std::vector<HighScore> &highScores = GetHighScores();
+  for (int i = 0; i < (int)highScores.size(); i++) {
+    if (time < highScores[i].time) {
       return i + 1;
     }
   }
-  if (data.highScores.size() < 10) {
-    return (int)data.highScores.size() + 1;
+  if (highScores.size() < 10) {
+    return (int)highScores.size() + 1;
   }
   return -1;
 }
@@ -72,8 +101,8 @@ bool StatManager::IsValidName(const std::string &name) const {
     return false;
 
   // Bad name filter
-  std::vector<std::string> blacklist = {"ass", "fuck", "shit", "bitch",
-                                        "nigger"};
+  static const char *const blacklist[] = {"ass", "fuck", "shit", "bitch",
+                                          "nigger"};
   std::string lowerName = name;
   std::transform(lowerName.begin(), lowerName.end(), lowerName.begin(),
                  ::tolower);
@@ -86,83 +115,61 @@ bool StatManager::IsValidName(const std::string &name) const {
   return true;
 }
 
-void StatManager::Save() {
-  std::ofstream out(filename);
-  if (out.is_open()) {
-    out << data.gamesStarted << " " << data.gamesWon << " " << data.gamesLost
-        << " " << data.gamesIncomplete << " " << data.totalMinesFlagged << " "
-        << data.noGuessMode << " " << data.winTimes.size() << " "
-        << data.highScores.size() << "\n";
-
-    for (float t : data.winTimes)
-      out << t << " ";
-    out << "\n";
-
-    for (const auto &hs : data.highScores) {
-      out << hs.name << " " << hs.time << "\n";
-    }
+void StatManager::Save() { writer.RequestCompaction(); }
+
+int StatManager::ReplayJournal(uint32_t generation, bool &intact) {
+  TRACE_SCOPE("StatManager::ReplayJournal");
+  // A missing journal has nothing to repair; the writer creates it.
+  FILE *file = std::fopen((filename + ".journal").c_str(), "rb");
+  intact = file == nullptr;
+  if (file == nullptr)
+    return 0;
+
+  int replayed = 0;
+  JournalHeader header;
+  if (std::fread(&header, sizeof(header), 1, file) != 1 ||
+      header.generation != generation) {
+    std::fclose(file);
+    return 0;
   }
-
-#if defined(PLATFORM_WEB)
-  EM_ASM({
-    if (window["sync_to_idbfs"]) {
-      window["sync_to_idbfs"]();
-    }
-  });
-#endif
-}
-
-void StatManager::Load() {
-  std::ifstream in(filename);
-  if (in.is_open()) {
-    int winCount = 0;
-    int hsCount = 0;
-    in >> data.gamesStarted >> data.gamesWon >> data.gamesLost >>
-        data.gamesIncomplete >> data.totalMinesFlagged >> data.noGuessMode >>
-        winCount >> hsCount;
-
-    data.winTimes.clear();
-    for (int i = 0; i < winCount; i++) {
-      float t;
-      in >> t;
-      data.winTimes.push_back(t);
-    }
-
-    data.highScores.clear();
-    for (int i = 0; i < hsCount; i++) {
-      std::string name;
-      float time;
-      in >> name >> time;
-      data.highScores.push_back({name, time});
+  if (std::memcmp(header.magic, journalMagic, sizeof(journalMagic)) == 0 &&
+      header.recordSize == sizeof(JournalRecord)) {
+    // Replay stops at the first torn or corrupt record; nothing after it
+    // can be trusted to be in order.
+    intact = true;
+    JournalRecord record;
+    while (std::fread(&record, sizeof(record), 1, file) == 1) {
+      if (record.checksum != JournalRecordChecksum(record)) {
+        intact = false;
+        break;
+      }
+      ApplyJournalRecord(data, record);
+      replayed++;
     }
+    // A partial record at the end reads as EOF; check the byte count.
+    long expected = (long)(sizeof(header) + replayed * header.recordSize);
+    if (intact && std::ftell(file) != expected)
+      intact = false;
   }
+  std::fclose(file);
+  return replayed;
 }
 
-float StatManager::GetFastestTime() const {
-  if (data.winTimes.empty())
-    return 0.0f;
-  float fastest = data.winTimes[0];
-  for (float t : data.winTimes)
-    if (t < fastest)
-      fastest = t;
-  return fastest;
+void StatManager::Load() {
+  TRACE_SCOPE("StatManager::Load");
+  if (!persistent)
+    return;
+  writer.Stop();
+  uint32_t generation = 0;
+  bool current = ReadStatsSnapshot(filename, data, generation);
+
+  // A replayed or damaged journal is folded into a fresh snapshot, so the
+  // next start replays nothing and appends never follow a torn record. A
+  // legacy text snapshot is migrated the same way.
+  bool intact = false;
+  int replayed = ReplayJournal(generation, intact);
+  writer.Start(filename, data, generation,
+               replayed > 0 || !intact || !current);
 }
 
-float StatManager::GetSlowestTime() const {
-  if (data.winTimes.empty())
-    return 0.0f;
-  float slowest = data.winTimes[0];
-  for (float t : data.winTimes)
-    if (t > slowest)
-      slowest = t;
-  return slowest;
-}
 
-float StatManager::GetAverageTime() const {
-  if (data.winTimes.empty())
-    return 0.0f;
-  float sum = 0.0f;
-  for (float t : data.winTimes)
-    sum += t;
-  return sum / data.winTimes.size();
-}
@@ -1,31 +1,37 @@
 #pragma once
+#include "GameHistory.h"
+#include "StatJournal.h"
+#include "StatWriter.h"
 #include <string>
 #include <vector>
 
-struct HighScore {
-  std::string name;
-  float time;
-};
-
-struct StatsData {
-  int gamesStarted = 0;
-  int gamesWon = 0;
-  int gamesLost = 0;
-  int gamesIncomplete = 0;
-  std::vector<float> winTimes;
-  std::vector<HighScore> highScores;
-  int totalMinesFlagged = 0;
-  bool noGuessMode = false;
-};
-
+// Stats live in a snapshot file plus an append-only journal next to it
+// (`<filename>.journal`). Every change is applied in memory and handed to a
+// StatWriter as one fixed-size journal record, so recording never waits on
+// the disk and costs the same however long the history is. At load the
+// journal tail is replayed, dropping a torn record left by a crash.
 class StatManager {
 public:
+  // An empty filename keeps everything in memory and touches no files, for
+  // trace runs and benchmarks that must not change the player's stats.
   StatManager(const std::string &filename);
+  ~StatManager();
+  StatManager(const StatManager &) = delete;
+  StatManager &operator=(const StatManager &) = delete;
+
+  // Games, high scores and lookups below all apply to this configuration.
+  // Set it when a game starts so a mode change mid-game cannot move the
+  // game's result to another leaderboard.
+  void SetConfig(const StatsKey &key) { config = key; }
+  const StatsKey &GetConfig() const { return config; }
 
   void RecordGame(bool won, bool lost, float time, int minesFlagged);
   void RecordStart();
   void RecordIncomplete();
+  // Writes a snapshot of the current stats and starts an empty journal.
   void Save();
+  // Blocks until every change so far is on disk, e.g. before exit().
+  void Flush() { writer.Flush(); }
   void Load();
 
   void AddHighScore(const std::string &name, float time);
@@ -33,23 +39,47 @@ public:
   int GetRankForTime(float time) const;
   bool IsValidName(const std::string &name) const;
 
-  void SetNoGuessMode(bool enabled) {
-    data.noGuessMode = enabled;
-    Save();
-  }
-  bool GetNoGuessMode() const { return data.noGuessMode; }
+  // Appends one game to the per-game history kept beside the stats
+  // (`<filename>.history`). Like the journal, it is written by the writer.
+  void RecordHistory(const GameRecord &record);
+  // The history as of the last row on disk.
+  const GameHistory &GetHistory();
+  // Writes a finished replay to `path` on the writer thread.
+  void SaveReplay(const std::string &path, std::vector<unsigned char> bytes);
 
+  void SetNoGuessMode(bool enabled);
+  bool GetNoGuessMode() const { return data.noGuessMode; }
   const StatsData &GetData() const { return data; }
+  // Stats of the current configuration; empty if it was never played.
+  const ConfigStats &GetConfigStats() const;
 
-  float GetFastestTime() const;
-  float GetSlowestTime() const;
-  float GetAverageTime() const;
+  // Win time aggregates; all are kept up to date as games are recorded.
+  float GetFastestTime() const { return GetConfigStats().winTimes.min; }
+  float GetSlowestTime() const { return GetConfigStats().winTimes.max; }
+  float GetAverageTime() const {
+    return GetConfigStats().winTimes.GetAverage();
+  }
+  float GetMedianTime() const { return GetConfigStats().winTimes.median; }
+  float GetP90Time() const { return GetConfigStats().winTimes.p90; }
+  float GetRecentAverageTime() const {
+    return GetConfigStats().winTimes.GetRecentAverage();
+  }
+  int GetRecentCount() const {
+    return GetConfigStats().winTimes.GetRecentCount();
+  }
   const std::vector<HighScore> &GetHighScores() const {
-    return data.highScores;
+    return GetConfigStats().highScores;
   }
 
 private:
   std::string filename;
   std::string baseFilename;
+  bool persistent;
   StatsData data;
+  StatsKey config;
+  StatWriter writer;
+  GameHistory history;
+
+  void Append(const JournalRecord &record);
+  int ReplayJournal(uint32_t generation, bool &intact);
 };
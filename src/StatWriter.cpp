@@ -0,0 +1,327 @@
+#include "StatWriter.h"
+#include "AllocTracker.h"
+#include "Trace.h"
+#include <cstring>
+#include <filesystem>
+#if defined(PLATFORM_WEB)
+#include <emscripten/emscripten.h>
+#include <emscripten/html5.h>
+#else
+#include <chrono>
+#endif
+
+#if defined(PLATFORM_WEB)
+// A hidden tab may never run its timers again, so pending records are
+// written as soon as the page is hidden or closed.
+static EM_BOOL FlushOnVisibilityChange(
+    int, const EmscriptenVisibilityChangeEvent *event, void *arg) {
+  if (event->hidden)
+    static_cast<StatWriter *>(arg)->Flush();
+  return EM_FALSE;
+}
+
+static const char *FlushOnUnload(int, const void *, void *arg) {
+  static_cast<StatWriter *>(arg)->Flush();
+  return nullptr;
+}
+
+void StatWriter::OnTimer(void *arg) {
+  StatWriter *writer = static_cast<StatWriter *>(arg);
+  writer->timerScheduled = false;
+  writer->WritePending();
+}
+#endif
+
+StatWriter::~StatWriter() { Stop(); }
+
+void StatWriter::Start(const std::string &path, const StatsData &data,
+                       uint32_t generation, bool compact) {
+  Stop();
+  this->path = path;
+  this->data = data;
+  this->generation = generation;
+  compactRequested = compact;
+  if (!compact)
+    OpenJournal(false);
+  history.Open(HistoryPath());
+  PublishHistory();
+  started = true;
+
+#if defined(PLATFORM_WEB)
+  emscripten_set_visibilitychange_callback(this, EM_FALSE,
+                                           FlushOnVisibilityChange);
+  emscripten_set_beforeunload_callback(this, FlushOnUnload);
+  if (compact) {
+    timerScheduled = true;
+    emscripten_async_call(OnTimer, this, coalesceMs);
+  }
+#else
+  stopping = false;
+  flushRequested = false;
+  thread = std::thread(&StatWriter::Run, this);
+#endif
+}
+
+void StatWriter::Push(const JournalRecord &record) {
+  // Only a burst of more records than the queue holds within one window
+  // ever waits here.
+  while (!queue.Push(record)) {
+    Flush();
+  }
+  pushed.fetch_add(1, std::memory_order_release);
+
+#if defined(PLATFORM_WEB)
+  if (!timerScheduled) {
+    timerScheduled = true;
+    emscripten_async_call(OnTimer, this, coalesceMs);
+  }
+#else
+  // The writer never holds the lock while writing, so this cannot wait on
+  // the disk; taking it orders the wakeup after the writer's check.
+  { std::lock_guard<std::mutex> lock(mutex); }
+  wake.notify_one();
+#endif
+}
+
+void StatWriter::PushHistory(const GameRecord &record) {
+  while (!historyQueue.Push(record)) {
+    Flush();
+  }
+  pushed.fetch_add(1, std::memory_order_release);
+
+#if defined(PLATFORM_WEB)
+  if (!timerScheduled) {
+    timerScheduled = true;
+    emscripten_async_call(OnTimer, this, coalesceMs);
+  }
+#else
+  { std::lock_guard<std::mutex> lock(mutex); }
+  wake.notify_one();
+#endif
+}
+
+void StatWriter::PushReplay(const std::string &path,
+                            std::vector<unsigned char> bytes) {
+  {
+#if !defined(PLATFORM_WEB)
+    std::lock_guard<std::mutex> lock(mutex);
+#endif
+    replays.push_back({path, std::move(bytes)});
+    pushed.fetch_add(1, std::memory_order_release);
+  }
+
+#if defined(PLATFORM_WEB)
+  if (!timerScheduled) {
+    timerScheduled = true;
+    emscripten_async_call(OnTimer, this, coalesceMs);
+  }
+#else
+  wake.notify_one();
+#endif
+}
+
+void StatWriter::SyncHistory(GameHistory &reader) {
+  if (historyRows.load(std::memory_order_acquire) == reader.GetRowCount())
+    return;
+#if !defined(PLATFORM_WEB)
+  std::lock_guard<std::mutex> lock(mutex);
+#endif
+  reader.Attach(HistoryPath(), historyChunks);
+}
+
+void StatWriter::PublishHistory() {
+#if !defined(PLATFORM_WEB)
+  std::lock_guard<std::mutex> lock(mutex);
+#endif
+  historyChunks = history.GetChunks();
+  historyRows.store(history.GetRowCount(), std::memory_order_release);
+}
+
+void StatWriter::RequestCompaction() {
+  compactRequested = true;
+  Flush();
+}
+
+void StatWriter::Flush() {
+  if (!started)
+    return;
+#if defined(PLATFORM_WEB)
+  WritePending();
+#else
+  uint64_t target = pushed.load(std::memory_order_acquire);
+  std::unique_lock<std::mutex> lock(mutex);
+  flushRequested = true;
+  wake.notify_one();
+  done.wait(lock, [&] {
+    return written.load() >= target && !compactRequested.load();
+  });
+#endif
+}
+
+void StatWriter::Stop() {
+  if (!started)
+    return;
+#if defined(PLATFORM_WEB)
+  WritePending();
+  emscripten_set_visibilitychange_callback(nullptr, EM_FALSE, nullptr);
+  emscripten_set_beforeunload_callback(nullptr, nullptr);
+#else
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wake.notify_one();
+  thread.join();
+#endif
+  if (journal != nullptr)
+    std::fclose(journal);
+  journal = nullptr;
+  history.Close();
+  started = false;
+}
+
+#if !defined(PLATFORM_WEB)
+void StatWriter::Run() {
+  TRACE_THREAD_NAME("stats writer");
+  AllocScope scope(ALLOC_STORAGE);
+  auto pending = [&] {
+    return pushed.load(std::memory_order_acquire) != written.load() ||
+           compactRequested.load();
+  };
+
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    wake.wait(lock, [&] { return stopping || flushRequested || pending(); });
+    // Let the rest of a burst arrive so it is written in one go.
+    if (!stopping && !flushRequested) {
+      wake.wait_for(lock, std::chrono::milliseconds(coalesceMs),
+                    [&] { return stopping || flushRequested; });
+    }
+    flushRequested = false;
+    bool exiting = stopping;
+
+    lock.unlock();
+    WritePending();
+    lock.lock();
+    done.notify_all();
+    if (exiting && !pending())
+      break;
+  }
+}
+#endif
+
+void StatWriter::WritePending() {
+  TRACE_SCOPE("StatWriter::WritePending");
+  // The whole batch goes through the FILE buffer and out in one flush.
+  uint64_t count = 0;
+  JournalRecord record;
+  while (queue.Pop(record)) {
+    ApplyJournalRecord(data, record);
+    record.checksum = JournalRecordChecksum(record);
+    if (journal != nullptr)
+      std::fwrite(&record, sizeof(record), 1, journal);
+    journalRecords++;
+    count++;
+  }
+  // Game rows are rare, so each one still goes out with its own flush.
+  size_t rows = 0;
+  GameRecord row;
+  while (historyQueue.Pop(row)) {
+    history.Append(row);
+    rows++;
+  }
+  if (rows > 0)
+    PublishHistory();
+  count += rows;
+
+  std::vector<PendingReplay> ready;
+  {
+#if !defined(PLATFORM_WEB)
+    std::lock_guard<std::mutex> lock(mutex);
+#endif
+    ready.swap(replays);
+  }
+  for (const PendingReplay &replay : ready)
+    WriteReplay(replay);
+  count += ready.size();
+
+  bool appended = journal != nullptr && std::fflush(journal) == 0 &&
+                  !std::ferror(journal);
+  // A failed append is repaired by a snapshot of the writer's copy, which
+  // already includes the batch.
+  bool compact = compactRequested.exchange(false);
+  if (compact || (count > 0 && !appended) ||
+      journalRecords >= compactEvery) {
+    Compact();
+    compact = true;
+  }
+  written.fetch_add(count);
+
+#if defined(PLATFORM_WEB)
+  if (count > 0 || compact) {
+    EM_ASM({
+      if (window["sync_to_idbfs"]) {
+        window["sync_to_idbfs"]();
+      }
+    });
+  }
+#endif
+}
+
+void StatWriter::WriteReplay(const PendingReplay &replay) {
+  TRACE_SCOPE("StatWriter::WriteReplay");
+  namespace fs = std::filesystem;
+  fs::path path(replay.path);
+  std::error_code ec;
+  if (path.has_parent_path())
+    fs::create_directories(path.parent_path(), ec);
+  fs::path target = path;
+  for (int n = 2; fs::exists(target, ec); n++) {
+    target = path.parent_path() / (path.stem().string() + "-" +
+                                   std::to_string(n) +
+                                   path.extension().string());
+  }
+
+  FILE *file = std::fopen(target.string().c_str(), "wb");
+  if (file == nullptr)
+    return;
+  std::fwrite(replay.bytes.data(), 1, replay.bytes.size(), file);
+  std::fclose(file);
+}
+
+bool StatWriter::Compact() {
+  TRACE_SCOPE("StatWriter::Compact");
+  if (!WriteStatsSnapshot(path, data, generation + 1))
+    return false;
+  generation++;
+  return OpenJournal(true);
+}
+
+bool StatWriter::OpenJournal(bool reset) {
+  if (journal != nullptr)
+    std::fclose(journal);
+  journalRecords = 0;
+
+  if (!reset) {
+    // Not "ab", which would create a journal without a header.
+    journal = std::fopen(JournalPath().c_str(), "r+b");
+    if (journal != nullptr)
+      std::fseek(journal, 0, SEEK_END);
+    return journal != nullptr;
+  }
+
+  journal = std::fopen(JournalPath().c_str(), "wb");
+  if (journal == nullptr)
+    return false;
+  JournalHeader header = {};
+  std::memcpy(header.magic, journalMagic, sizeof(journalMagic));
+  header.generation = generation;
+  header.recordSize = sizeof(JournalRecord);
+  if (std::fwrite(&header, sizeof(header), 1, journal) != 1 ||
+      std::fflush(journal) != 0) {
+    std::fclose(journal);
+    journal = nullptr;
+    return false;
+  }
+  return true;
+}
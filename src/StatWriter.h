@@ -0,0 +1,98 @@
+#pragma once
+#include "GameHistory.h"
+#include "SpscQueue.h"
+#include "StatJournal.h"
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <vector>
+#if !defined(PLATFORM_WEB)
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+// Persists StatManager's journal records off the game loop. Records pushed
+// within one coalescing window are written with a single append, and on the
+// web a single IndexedDB sync. The writer keeps its own copy of the stats,
+// replayed from the same records, to write compacted snapshots from. Rows
+// for the game history file are appended the same way, and finished
+// replays are written by the same thread.
+//
+// Desktop builds write on a background thread. The web build has no
+// threads, so it writes from a browser timer, and when the page is hidden or
+// unloaded.
+class StatWriter {
+public:
+  static constexpr int coalesceMs = 250;
+  static constexpr int compactEvery = 256;
+
+  StatWriter() = default;
+  ~StatWriter();
+  StatWriter(const StatWriter &) = delete;
+  StatWriter &operator=(const StatWriter &) = delete;
+
+  // Takes over the files at `path` from a load that left `data` at
+  // `generation`. With `compact`, the first write is a fresh snapshot.
+  void Start(const std::string &path, const StatsData &data,
+             uint32_t generation, bool compact);
+  // Queues a record. Never touches the disk on the calling thread.
+  void Push(const JournalRecord &record);
+  // Queues a row for `<path>.history`, also without touching the disk.
+  void PushHistory(const GameRecord &record);
+  // Points `reader` at the history file as of the last written row, if rows
+  // were written since it was last updated.
+  void SyncHistory(GameHistory &reader);
+  // Queues a finished replay for `path`. A name already taken gets a
+  // numbered suffix rather than being overwritten.
+  void PushReplay(const std::string &path, std::vector<unsigned char> bytes);
+  // Asks for a fresh snapshot and an empty journal on the next write.
+  void RequestCompaction();
+  // Blocks until every record pushed so far is on disk.
+  void Flush();
+  void Stop();
+
+private:
+  std::string path;
+  StatsData data;
+  uint32_t generation = 0;
+  FILE *journal = nullptr;
+  int journalRecords = 0;
+
+  SpscQueue<JournalRecord, 256> queue;
+  GameHistory history;
+  SpscQueue<GameRecord, 64> historyQueue;
+  // Zone maps as of the last written row, copied out for SyncHistory.
+  std::vector<HistoryChunkHeader> historyChunks;
+  std::atomic<size_t> historyRows{0};
+  struct PendingReplay {
+    std::string path;
+    std::vector<unsigned char> bytes;
+  };
+  std::vector<PendingReplay> replays; // Guarded by `mutex` on desktop
+  std::atomic<bool> compactRequested{false};
+  std::atomic<uint64_t> pushed{0};
+  std::atomic<uint64_t> written{0};
+  bool started = false;
+
+#if defined(PLATFORM_WEB)
+  bool timerScheduled = false;
+  static void OnTimer(void *arg);
+#else
+  std::thread thread;
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable done;
+  bool stopping = false;
+  bool flushRequested = false;
+  void Run();
+#endif
+
+  void WritePending();
+  bool Compact();
+  bool OpenJournal(bool reset);
+  void PublishHistory();
+  void WriteReplay(const PendingReplay &replay);
+  std::string JournalPath() const { return path + ".journal"; }
+  std::string HistoryPath() const { return path + ".history"; }
+};
@@ -0,0 +1,11 @@
+#pragma once
+
+// Summary of one tileSize x tileSize block of the board. Kept up to date as
+// cells change so full-board passes can skip settled regions.
+struct Tile {
+  int cells = 0;
+  int revealed = 0;
+  int flagged = 0;
+  int mines = 0;
+  unsigned int version = 0; // Bumped whenever any cell in the tile changes
+};
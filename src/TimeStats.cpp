@@ -0,0 +1,66 @@
+#include "TimeStats.h"
+#include <algorithm>
+#include <cmath>
+
+static const float logRange = std::log(TimeStats::maxTime / TimeStats::minTime);
+
+int TimeStats::BinFor(float time) {
+  if (!(time > minTime))
+    return 0;
+  int bin = (int)(std::log(time / minTime) / logRange * binCount);
+  return std::min(bin, binCount - 1);
+}
+
+float TimeStats::BinStart(int bin) {
+  return minTime * std::exp(logRange * bin / binCount);
+}
+
+void TimeStats::Add(float time) {
+  if (count == 0 || time < min)
+    min = time;
+  if (count == 0 || time > max)
+    max = time;
+  count++;
+  sum += time;
+  bins[BinFor(time)]++;
+
+  recent[recentHead] = time;
+  recentHead = (recentHead + 1) % recentCount;
+  Refresh();
+}
+
+void TimeStats::Refresh() {
+  // Summed afresh so rounding cannot build up over millions of games.
+  recentSum = 0.0;
+  for (float time : recent)
+    recentSum += time;
+  median = GetQuantile(0.5f);
+  p90 = GetQuantile(0.9f);
+}
+
+float TimeStats::GetRecentAverage() const {
+  int n = GetRecentCount();
+  return n > 0 ? (float)(recentSum / n) : 0.0f;
+}
+
+float TimeStats::GetQuantile(float q) const {
+  if (count == 0)
+    return 0.0f;
+  // Interpolates geometrically inside the bin holding the target rank, then
+  // clamps to the exact extremes.
+  double target = q * (count - 1);
+  double seen = 0.0;
+  for (int bin = 0; bin < binCount; bin++) {
+    if (bins[bin] == 0)
+      continue;
+    if (seen + bins[bin] > target) {
+      double fraction = (target - seen + 0.5) / bins[bin];
+      float lo = BinStart(bin);
+      float hi = BinStart(bin + 1);
+      float value = lo * (float)std::pow(hi / lo, fraction);
+      return std::max(min, std::min(value, max));
+    }
+    seen += bins[bin];
+  }
+  return max;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+
+// Aggregates over a stream of game times in constant memory: running
+// min/max/sum, a log-spaced histogram for quantiles and a ring of the most
+// recent times. Nothing is scanned per query, so reading stats costs the
+// same after millions of games as after ten.
+struct TimeStats {
+  // Bins cover minTime..maxTime seconds, each about 2% wider than the last,
+  // so quantiles are accurate to about 1%. Times outside land in the first
+  // or last bin.
+  static constexpr int binCount = 512;
+  static constexpr float minTime = 0.1f;
+  static constexpr float maxTime = 2000.0f;
+  static constexpr int recentCount = 100;
+
+  int count = 0;
+  float min = 0.0f;
+  float max = 0.0f;
+  double sum = 0.0;
+  uint32_t bins[binCount] = {};
+  float recent[recentCount] = {}; // Ring buffer of the latest times
+  int recentHead = 0;             // Slot the next time is written to
+  double recentSum = 0.0;
+
+  // Refreshed by Add and Refresh rather than per query.
+  float median = 0.0f;
+  float p90 = 0.0f;
+
+  void Add(float time);
+  // Recomputes the cached quantiles after the fields are set directly.
+  void Refresh();
+
+  float GetAverage() const { return count > 0 ? (float)(sum / count) : 0.0f; }
+  int GetRecentCount() const {
+    return count < recentCount ? count : recentCount;
+  }
+  float GetRecentAverage() const;
+  float GetQuantile(float q) const;
+
+  static int BinFor(float time);
+  static float BinStart(int bin);
+};
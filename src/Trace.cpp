@@ -0,0 +1,132 @@
+#include "Trace.h"
+
+#if defined(MINESWEEPER_TRACING)
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace {
+
+struct TraceEvent {
+  const char *name;
+  const char *argName;
+  long long arg;
+  long long startNs;
+  long long endNs;
+};
+
+const size_t chunkSize = 4096;
+const size_t maxChunks = 1024; // About 4M events per thread
+
+// Events recorded by one thread. Only the owning thread appends; it fills
+// an event, then publishes it by bumping `count` with release ordering, so
+// the writer can read everything below `count` without locking.
+struct ThreadBuffer {
+  TraceEvent *chunks[maxChunks] = {};
+  std::atomic<size_t> count{0};
+  std::atomic<const char *> threadName{nullptr};
+  int tid = 0;
+  ThreadBuffer *next = nullptr;
+};
+
+std::atomic<ThreadBuffer *> buffers{nullptr};
+std::atomic<int> nextTid{1};
+std::atomic<size_t> dropped{0};
+thread_local ThreadBuffer *localBuffer = nullptr;
+std::string outputPath = "trace.json";
+const std::chrono::steady_clock::time_point startTime =
+    std::chrono::steady_clock::now();
+
+ThreadBuffer *GetBuffer() {
+  if (localBuffer != nullptr)
+    return localBuffer;
+  // Buffers live until exit; they are linked with a CAS push so a new
+  // thread never waits on another.
+  ThreadBuffer *buffer = new ThreadBuffer();
+  buffer->tid = nextTid.fetch_add(1);
+  buffer->next = buffers.load(std::memory_order_relaxed);
+  while (!buffers.compare_exchange_weak(buffer->next, buffer,
+                                        std::memory_order_release,
+                                        std::memory_order_relaxed)) {
+  }
+  localBuffer = buffer;
+  return buffer;
+}
+
+void WriteAtExit() { Tracing::Write(); }
+const bool writeRegistered = (std::atexit(WriteAtExit), true);
+
+} // namespace
+
+long long Tracing::Now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - startTime)
+      .count();
+}
+
+void Tracing::Record(const char *name, const char *argName, long long arg,
+                     long long startNs, long long endNs) {
+  ThreadBuffer *buffer = GetBuffer();
+  size_t index = buffer->count.load(std::memory_order_relaxed);
+  size_t chunk = index / chunkSize;
+  if (chunk >= maxChunks) {
+    dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  if (buffer->chunks[chunk] == nullptr)
+    buffer->chunks[chunk] = new TraceEvent[chunkSize];
+  buffer->chunks[chunk][index % chunkSize] = {name, argName, arg, startNs,
+                                              endNs};
+  buffer->count.store(index + 1, std::memory_order_release);
+}
+
+void Tracing::SetThreadName(const char *name) {
+  GetBuffer()->threadName.store(name, std::memory_order_release);
+}
+
+void Tracing::SetOutputPath(const char *path) { outputPath = path; }
+
+bool Tracing::Write() {
+  FILE *file = std::fopen(outputPath.c_str(), "w");
+  if (file == nullptr)
+    return false;
+
+  std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+  bool first = true;
+  for (ThreadBuffer *buffer = buffers.load(std::memory_order_acquire);
+       buffer != nullptr; buffer = buffer->next) {
+    const char *threadName = buffer->threadName.load(std::memory_order_acquire);
+    if (threadName != nullptr) {
+      std::fprintf(file,
+                   "%s\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,"
+                   "\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                   first ? "" : ",", buffer->tid, threadName);
+      first = false;
+    }
+
+    size_t count = buffer->count.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; i++) {
+      const TraceEvent &e = buffer->chunks[i / chunkSize][i % chunkSize];
+      std::fprintf(file,
+                   "%s\n{\"ph\":\"X\",\"name\":\"%s\",\"pid\":1,\"tid\":%d,"
+                   "\"ts\":%.3f,\"dur\":%.3f",
+                   first ? "" : ",", e.name, buffer->tid, e.startNs / 1000.0,
+                   (e.endNs - e.startNs) / 1000.0);
+      if (e.argName != nullptr)
+        std::fprintf(file, ",\"args\":{\"%s\":%lld}", e.argName, e.arg);
+      std::fprintf(file, "}");
+      first = false;
+    }
+  }
+  std::fprintf(file, "\n]}\n");
+
+  if (dropped.load() > 0) {
+    std::fprintf(stderr, "TRACE: %zu events dropped, buffers full\n",
+                 dropped.load());
+  }
+  return std::fclose(file) == 0;
+}
+
+#endif
@@ -0,0 +1,57 @@
+#pragma once
+
+// Scoped trace events in Chrome trace-event format, written to a JSON file at
+// exit and viewable in chrome://tracing or Perfetto. Compiled in with the
+// MINESWEEPER_TRACING CMake option; otherwise every macro expands to nothing.
+//
+//   TRACE_SCOPE("Board::Reveal");
+//   TRACE_SCOPE_ARG("GenerateNoGuess attempt", "attempt", attempts);
+//
+// Names must be string literals: only the pointer is stored.
+#if defined(MINESWEEPER_TRACING)
+
+class Tracing {
+public:
+  static long long Now(); // Nanoseconds since startup
+  static void Record(const char *name, const char *argName, long long arg,
+                     long long startNs, long long endNs);
+  static void SetThreadName(const char *name);
+  static void SetOutputPath(const char *path);
+  static bool Write();
+};
+
+class TraceScope {
+public:
+  explicit TraceScope(const char *name, const char *argName = nullptr,
+                      long long arg = 0)
+      : name(name), argName(argName), arg(arg), startNs(Tracing::Now()) {}
+  ~TraceScope() {
+    Tracing::Record(name, argName, arg, startNs, Tracing::Now());
+  }
+  TraceScope(const TraceScope &) = delete;
+  TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+  const char *name;
+  const char *argName;
+  long long arg;
+  long long startNs;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+#define TRACE_SCOPE_ARG(name, argName, value)                                  \
+  TraceScope TRACE_CONCAT(traceScope, __LINE__)(name, argName,                 \
+                                                (long long)(value))
+#define TRACE_THREAD_NAME(name) Tracing::SetThreadName(name)
+#define TRACE_OUTPUT_FILE(path) Tracing::SetOutputPath(path)
+
+#else
+
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_SCOPE_ARG(name, argName, value) ((void)0)
+#define TRACE_THREAD_NAME(name) ((void)0)
+#define TRACE_OUTPUT_FILE(path) ((void)0)
+
+#endif
@@ -1,21 +1,24 @@
 #include "UI.h"
-#include <iomanip>
-#include <sstream>
-#include <string>
-
-UI::UI(Board &board, StatManager &stats) : board(board), stats(stats) {
-  Image img = LoadImage("flag.ico");
-  if (img.data != nullptr) {
-    mineTexture = LoadTextureFromImage(img);
-    UnloadImage(img);
-    textureLoaded = true;
-  }
-}
+#include "AllocTracker.h"
+#include "Assets.h"
+#include "GridShader.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+
+UI::UI(Board &board, StatManager &stats, InputSource &input)
+    : board(board), stats(stats), input(input) {}
 
 UI::~UI() {
   if (textureLoaded) {
     UnloadTexture(mineTexture);
   }
+  if (boardTextureLoaded) {
+    UnloadRenderTexture(boardTexture);
+  }
+  UnloadGridShader();
+  atlas.Unload();
 }
 
 void UI::Update(float currentTime) {
@@ -34,19 +37,19 @@ void UI::Update(float currentTime) {
   }
 
   if (enteringName) {
-    int key = GetCharPressed();
+    int key = input.GetCharPressed();
     while (key > 0) {
       if ((key >= 32) && (key <= 125) && (nameCharCount < 15)) {
         playerName[nameCharCount] = (char)key;
         playerName[nameCharCount + 1] = '\0';
         nameCharCount++;
       }
-      key = GetCharPressed();
+      key = input.GetCharPressed();
     }
 
-    if (IsKeyDown(KEY_BACKSPACE)) {
-      backspaceTimer += GetFrameTime();
-      if (IsKeyPressed(KEY_BACKSPACE) ||
+    if (input.IsKeyDown(KEY_BACKSPACE)) {
+      backspaceTimer += input.GetFrameTime();
+      if (input.IsKeyPressed(KEY_BACKSPACE) ||
           (backspaceTimer > 0.5f &&
            (backspaceTimer - 0.5f) > backspaceInterval)) {
         if (backspaceTimer > 0.5f) {
@@ -62,7 +65,7 @@ void UI::Update(float currentTime) {
       backspaceTimer = 0.0f;
     }
 
-    if (IsKeyPressed(KEY_ENTER) && nameCharCount > 0) {
+    if (input.IsKeyPressed(KEY_ENTER) && nameCharCount > 0) {
       if (stats.IsValidName(playerName)) {
         stats.AddHighScore(playerName, lastTimeRecord);
         enteringName = false;
@@ -74,43 +77,95 @@ void UI::Update(float currentTime) {
   }
 }
 
-void UI::Draw(float currentTime, bool showStats) {
-  DrawCustomTitleBar();
-  DrawStatusHeader(currentTime);
+void UI::Prepare() {
+  if (!atlas.IsBuilt() || atlas.GetCellSize() != cellSize) {
+    AllocScope scope(ALLOC_RESOURCES);
+    // Loaded here rather than in the constructor, which runs before Game
+    // has created the window and its GL context.
+    const Image &flag = Assets::GetFlagImage();
+    if (!textureLoaded && flag.data != nullptr) {
+      mineTexture = LoadTextureFromImage(flag);
+      textureLoaded = true;
+    }
+    atlas.Build(cellSize, textureLoaded ? &mineTexture : nullptr);
+  }
+  SyncCamera();
 
-  int offsetX = (GetScreenWidth() - board.GetWidth() * cellSize) / 2;
-  int offsetY = topBarHeight + 20;
+  if (useGridShader && (board.GetWidth() > maxStateTextureSize ||
+                        board.GetHeight() > maxStateTextureSize)) {
+    TraceLog(LOG_WARNING, "UI: Board too large for the grid shader");
+    useGridShader = false;
+  }
+  if (useGridShader && !gridShaderLoaded) {
+    AllocScope scope(ALLOC_RESOURCES);
+    if (!LoadGridShader()) {
+      TraceLog(LOG_WARNING, "UI: Grid shader unavailable, using cached board");
+      useGridShader = false;
+    }
+  }
+  if (useGridShader) {
+    UpdateStateTexture();
+  } else if (UsesBoardTexture()) {
+    UpdateBoardTexture();
+  }
+}
+
+void UI::Draw(float currentTime, int clicks, bool showStats) {
+  TRACE_SCOPE("UI::Draw");
+  Prepare();
+  Rectangle area = GetBoardArea();
 
-  DrawRectangle(offsetX - 10, offsetY - 10, board.GetWidth() * cellSize + 20,
+  DrawCustomTitleBar();
+  DrawStatusHeader(currentTime, clicks);
+
+  BeginScissorMode(0, topBarHeight, GetScreenWidth(),
+                   GetScreenHeight() - topBarHeight);
+  BeginMode2D(camera);
+  DrawRectangle(-10, -10, board.GetWidth() * cellSize + 20,
                 board.GetHeight() * cellSize + 20, Color{33, 37, 43, 255});
 
-  for (int y = 0; y < board.GetHeight(); y++) {
-    for (int x = 0; x < board.GetWidth(); x++) {
-      DrawCell(x, y, offsetX, offsetY);
+  if (useGridShader) {
+    DrawBoardShader();
+  } else if (UsesBoardTexture()) {
+    // Render textures are stored bottom-up, hence the negative source height.
+    DrawTextureRec(boardTexture.texture,
+                   {0, 0, (float)boardTexture.texture.width,
+                    -(float)boardTexture.texture.height},
+                   {0, 0}, WHITE);
+  } else {
+    int x0, y0, x1, y1;
+    GetVisibleCells(x0, y0, x1, y1);
+    for (int y = y0; y < y1; y++) {
+      for (int x = x0; x < x1; x++) {
+        DrawCell(x, y, 0, 0);
+      }
     }
   }
+  EndMode2D();
+  EndScissorMode();
 
+  int centerY = (int)(area.y + area.height / 2);
   if (enteringName) {
     DrawNameEntry();
   } else if (board.IsGameWon()) {
     DrawRectangle(0, 0, GetScreenWidth(), GetScreenHeight(),
                   Color{0, 255, 0, 40});
     DrawText("VICTORY!", GetScreenWidth() / 2 - MeasureText("VICTORY!", 40) / 2,
-             offsetY + board.GetHeight() * cellSize / 2 - 40, 40, GREEN);
+             centerY - 40, 40, GREEN);
     DrawText("Press any key to restart",
              GetScreenWidth() / 2 -
                  MeasureText("Press any key to restart", 20) / 2,
-             offsetY + board.GetHeight() * cellSize / 2 + 10, 20, RAYWHITE);
+             centerY + 10, 20, RAYWHITE);
   } else if (board.IsGameOver()) {
     DrawRectangle(0, 0, GetScreenWidth(), GetScreenHeight(),
                   Color{255, 0, 0, 40});
     DrawText("GAME OVER",
              GetScreenWidth() / 2 - MeasureText("GAME OVER", 40) / 2,
-             offsetY + board.GetHeight() * cellSize / 2 - 40, 40, RED);
+             centerY - 40, 40, RED);
     DrawText("Press any key to restart",
              GetScreenWidth() / 2 -
                  MeasureText("Press any key to restart", 20) / 2,
-             offsetY + board.GetHeight() * cellSize / 2 + 10, 20, RAYWHITE);
+             centerY + 10, 20, RAYWHITE);
   }
 
   if (showStats && !enteringName) {
@@ -126,13 +181,13 @@ void UI::DrawCustomTitleBar() {
   DrawText(title, GetScreenWidth() / 2 - MeasureText(title, fontSize) / 2,
            (titleBarHeight - fontSize) / 2, fontSize, RAYWHITE);
 
-  Color minColor = IsOverMinimize(GetMousePosition()) ? LIGHTGRAY : GRAY;
+  Color minColor = IsOverMinimize(input.GetMousePosition()) ? LIGHTGRAY : GRAY;
   DrawRectangle(GetScreenWidth() - 70, 0, 35, titleBarHeight,
-                IsOverMinimize(GetMousePosition()) ? Color{60, 60, 60, 255}
+                IsOverMinimize(input.GetMousePosition()) ? Color{60, 60, 60, 255}
                                                    : BLANK);
   DrawRectangle(GetScreenWidth() - 60, titleBarHeight / 2, 15, 2, minColor);
 
-  bool overClose = IsOverClose(GetMousePosition());
+  bool overClose = IsOverClose(input.GetMousePosition());
   DrawRectangle(GetScreenWidth() - 35, 0, 35, titleBarHeight,
                 overClose ? RED : BLANK);
   DrawLineEx({(float)GetScreenWidth() - 25, 10},
@@ -143,26 +198,39 @@ void UI::DrawCustomTitleBar() {
              overClose ? RAYWHITE : GRAY);
 }
 
-void UI::DrawStatusHeader(float currentTime) {
+void UI::DrawStatusHeader(float currentTime, int clicks) {
   DrawRectangle(0, titleBarHeight, GetScreenWidth(), statusHeaderHeight,
                 Color{33, 37, 43, 255});
   DrawLine(0, topBarHeight, GetScreenWidth(), topBarHeight, DARKGRAY);
 
-  std::stringstream ss;
-  ss << std::fixed << std::setprecision(1) << currentTime << "s";
-  std::string timeStr = ss.str();
-  DrawText(timeStr.c_str(),
-           GetScreenWidth() / 2 - MeasureText(timeStr.c_str(), 30) / 2,
+  // TextFormat writes into raylib's static buffers, so no per-frame strings.
+  const char *timeText = TextFormat("%.1fs", currentTime);
+  DrawText(timeText, GetScreenWidth() / 2 - MeasureText(timeText, 30) / 2,
            titleBarHeight + 15, 30, RAYWHITE);
 
-  std::string minesText = "MINES: " + std::to_string(board.GetMinesLeft());
-  DrawText(minesText.c_str(), 30, titleBarHeight + 20, 20,
-           Color{180, 180, 180, 255});
+  DrawText(TextFormat("MINES: %d", board.GetMinesLeft()), 30,
+           titleBarHeight + 10, 20, Color{180, 180, 180, 255});
 
-  std::string helpText = "'S' Stats | 'R' Restart | 'G' No-Guess: ";
-  helpText += (stats.GetNoGuessMode() ? "ON" : "OFF");
-  DrawText(helpText.c_str(), GetScreenWidth() - 380, titleBarHeight + 20, 18,
+  DrawText(stats.GetNoGuessMode()
+               ? "'S' Stats | 'R' Restart | 'G' No-Guess: ON"
+               : "'S' Stats | 'R' Restart | 'G' No-Guess: OFF",
+           GetScreenWidth() - 380, titleBarHeight + 10, 18,
            Color{150, 150, 150, 255});
+
+  // 3BV counters are kept by Board as cells are revealed, so these cost
+  // nothing per frame.
+  Color metricColor = {130, 130, 130, 255};
+  int solved = board.GetSolved3BV();
+  float rate = currentTime > 0.0f ? solved / currentTime : 0.0f;
+  DrawText(TextFormat("3BV %d/%d  %.2f/s", solved, board.Get3BV(), rate), 30,
+           titleBarHeight + 36, 14, metricColor);
+  const char *efficiency =
+      clicks > 0 ? TextFormat("CLICKS %d  EFF %d%%", clicks,
+                              (int)(100.0f * solved / clicks + 0.5f))
+                 : "CLICKS 0  EFF -";
+  // Right-aligned so it stays clear of the timer on narrow windows.
+  DrawText(efficiency, GetScreenWidth() - 30 - MeasureText(efficiency, 14),
+           titleBarHeight + 36, 14, metricColor);
 }
 
 bool UI::IsOverClose(Vector2 mouse) const {
@@ -180,92 +248,280 @@ bool UI::IsOverTitleBar(Vector2 mouse) const {
           !IsOverMinimize(mouse));
 }
 
-void UI::DrawCell(int x, int y, int offsetX, int offsetY) {
-  int posX = offsetX + x * cellSize;
-  int posY = offsetY + y * cellSize;
-  const Cell &cell = board.GetCell(x, y);
+void UI::UpdateCamera(bool keyboardPan) {
+  SyncCamera();
+  float wheel = input.GetMouseWheelMove();
+  Vector2 mouse = input.GetMousePosition();
+  if (wheel != 0.0f && CheckCollisionPointRec(mouse, GetBoardArea())) {
+    // Keep the point under the cursor fixed while zooming.
+    Vector2 before = GetScreenToWorld2D(mouse, camera);
+    camera.zoom *= std::pow(1.25f, wheel);
+    camera.zoom = std::max(GetMinZoom(), std::min(camera.zoom, 4.0f));
+    Vector2 after = GetScreenToWorld2D(mouse, camera);
+    camera.target.x += before.x - after.x;
+    camera.target.y += before.y - after.y;
+  }
 
-  float roundness = 0.2f;
-  int segments = 8;
-  Rectangle rect = {(float)posX + 2, (float)posY + 2, (float)cellSize - 4,
-                    (float)cellSize - 4};
+  if (keyboardPan) {
+    float step = 600.0f * input.GetFrameTime() / camera.zoom;
+    if (input.IsKeyDown(KEY_LEFT))
+      camera.target.x -= step;
+    if (input.IsKeyDown(KEY_RIGHT))
+      camera.target.x += step;
+    if (input.IsKeyDown(KEY_UP))
+      camera.target.y -= step;
+    if (input.IsKeyDown(KEY_DOWN))
+      camera.target.y += step;
+  }
+  ClampCamera();
+}
 
-  if (!cell.isRevealed) {
-    DrawRectangleRounded(rect, roundness, segments, Color{45, 50, 60, 255});
-    DrawRectangleRoundedLines(rect, roundness, segments, 1.0f,
-                              Color{60, 65, 75, 255});
+bool UI::ScreenToCell(Vector2 screen, int &x, int &y) const {
+  if (screen.y < topBarHeight)
+    return false;
+  Vector2 world = GetScreenToWorld2D(screen, camera);
+  x = (int)std::floor(world.x / cellSize);
+  y = (int)std::floor(world.y / cellSize);
+  return board.IsValid(x, y);
+}
 
-    if (cell.isFlagged) {
-      DrawFlag(posX + cellSize / 2, posY + cellSize / 2, cellSize / 2);
-    }
-  } else {
+Rectangle UI::GetBoardArea() const {
+  return {(float)boardPadding, (float)(topBarHeight + boardPadding),
+          (float)(GetScreenWidth() - 2 * boardPadding),
+          (float)(GetScreenHeight() - topBarHeight - 2 * boardPadding)};
+}
+
+float UI::GetMinZoom() const {
+  // Zooming out stops once the board fits, and never below 8px cells so the
+  // number of visible cells stays bounded on huge boards.
+  Rectangle area = GetBoardArea();
+  float fit = std::min(area.width / (board.GetWidth() * cellSize),
+                       area.height / (board.GetHeight() * cellSize));
+  return std::min(1.0f, std::max(fit, 0.25f));
+}
+
+void UI::SyncCamera() {
+  // A new board size starts centred at 1:1.
+  if (cameraBoardWidth != board.GetWidth() ||
+      cameraBoardHeight != board.GetHeight()) {
+    cameraBoardWidth = board.GetWidth();
+    cameraBoardHeight = board.GetHeight();
+    camera.target = {board.GetWidth() * cellSize / 2.0f,
+                     board.GetHeight() * cellSize / 2.0f};
+    camera.rotation = 0.0f;
+    camera.zoom = 1.0f;
+  }
+  Rectangle area = GetBoardArea();
+  camera.offset = {area.x + area.width / 2, area.y + area.height / 2};
+}
+
+void UI::ClampCamera() {
+  camera.target.x = std::max(
+      0.0f, std::min(camera.target.x, (float)board.GetWidth() * cellSize));
+  camera.target.y = std::max(
+      0.0f, std::min(camera.target.y, (float)board.GetHeight() * cellSize));
+}
+
+void UI::GetVisibleCells(int &x0, int &y0, int &x1, int &y1) const {
+  Vector2 topLeft = GetScreenToWorld2D({0, (float)topBarHeight}, camera);
+  Vector2 bottomRight = GetScreenToWorld2D(
+      {(float)GetScreenWidth(), (float)GetScreenHeight()}, camera);
+  x0 = std::max(0, (int)std::floor(topLeft.x / cellSize));
+  y0 = std::max(0, (int)std::floor(topLeft.y / cellSize));
+  x1 = std::min(board.GetWidth(), (int)std::ceil(bottomRight.x / cellSize));
+  y1 = std::min(board.GetHeight(), (int)std::ceil(bottomRight.y / cellSize));
+  x1 = std::max(x0, x1);
+  y1 = std::max(y0, y1);
+}
+
+bool UI::UsesBoardTexture() const {
+  return board.GetWidth() * cellSize <= maxCachedBoardSize &&
+         board.GetHeight() * cellSize <= maxCachedBoardSize;
+}
+
+void UI::DrawCell(int x, int y, int offsetX, int offsetY) {
+  atlas.Draw(GetCellVisual(x, y), (float)(offsetX + x * cellSize),
+             (float)(offsetY + y * cellSize));
+}
+
+CellVisual UI::GetCellVisual(int x, int y) const {
+  const Cell &cell = board.GetCell(x, y);
+  if (!cell.isRevealed)
+    return cell.isFlagged ? VISUAL_HIDDEN_FLAGGED : VISUAL_HIDDEN;
+  if (cell.isMine) {
     int clickedX, clickedY;
     board.GetClickedMine(clickedX, clickedY);
+    if (x == clickedX && y == clickedY)
+      return VISUAL_MINE_EXPLODED;
+    return cell.isFlagged ? VISUAL_MINE_FLAGGED : VISUAL_MINE;
+  }
+  if (cell.neighborMines > 0)
+    return (CellVisual)(VISUAL_NUMBER_1 + cell.neighborMines - 1);
+  return VISUAL_EMPTY;
+}
 
-    if (cell.isMine && x == clickedX && y == clickedY) {
-      DrawRectangleRounded(rect, roundness, segments, Color{255, 50, 50, 220});
-    } else {
-      DrawRectangleRounded(rect, roundness, segments, Color{28, 32, 38, 255});
-    }
+void UI::UpdateBoardTexture() {
+  int width = board.GetWidth() * cellSize;
+  int height = board.GetHeight() * cellSize;
+
+  if (!boardTextureLoaded || boardTexture.texture.width != width ||
+      boardTexture.texture.height != height) {
+    AllocScope scope(ALLOC_RESOURCES);
+    if (boardTextureLoaded)
+      UnloadRenderTexture(boardTexture);
+    boardTexture = LoadRenderTexture(width, height);
+    boardTextureLoaded = true;
+    cellCache.assign(board.GetWidth() * board.GetHeight(), VISUAL_NONE);
+    InvalidateTileVersions(tileVersions);
+  }
 
-    if (cell.isMine) {
-      DrawMine(posX + cellSize / 2, posY + cellSize / 2, cellSize / 2);
-      if (cell.isFlagged) {
-        DrawLineEx({(float)posX + 5, (float)posY + 5},
-                   {(float)posX + cellSize - 5, (float)posY + cellSize - 5},
-                   2.0f, GREEN);
-        DrawLineEx({(float)posX + cellSize - 5, (float)posY + 5},
-                   {(float)posX + 5, (float)posY + cellSize - 5}, 2.0f, GREEN);
+  // Tiles outside the view are left stale; their version check catches up
+  // once they scroll in.
+  int x0, y0, x1, y1;
+  GetVisibleCells(x0, y0, x1, y1);
+  int tx0 = x0 / Board::tileSize, ty0 = y0 / Board::tileSize;
+  int tx1 = (x1 + Board::tileSize - 1) / Board::tileSize;
+  int ty1 = (y1 + Board::tileSize - 1) / Board::tileSize;
+
+  bool drawing = false;
+  for (int ty = ty0; ty < ty1; ty++) {
+    for (int tx = tx0; tx < tx1; tx++) {
+      unsigned int version = board.GetTile(tx, ty).version;
+      unsigned int &cached = tileVersions[ty * board.GetTilesX() + tx];
+      if (cached == version)
+        continue;
+      cached = version;
+
+      int endX = std::min((tx + 1) * Board::tileSize, board.GetWidth());
+      int endY = std::min((ty + 1) * Board::tileSize, board.GetHeight());
+      for (int y = ty * Board::tileSize; y < endY; y++) {
+        for (int x = tx * Board::tileSize; x < endX; x++) {
+          CellVisual visual = GetCellVisual(x, y);
+          unsigned char &drawn = cellCache[y * board.GetWidth() + x];
+          if (drawn == visual)
+            continue;
+          drawn = visual;
+
+          if (!drawing) {
+            BeginTextureMode(boardTexture);
+            drawing = true;
+          }
+          DrawCell(x, y, 0, 0);
+        }
       }
-    } else if (cell.neighborMines > 0) {
-      Color color = GetNumberColor(cell.neighborMines);
-      std::string text = std::to_string(cell.neighborMines);
-      int width = MeasureText(text.c_str(), 20);
-      DrawText(text.c_str(), posX + (cellSize - width) / 2, posY + 6, 20,
-               color);
     }
   }
+
+  if (drawing)
+    EndTextureMode();
 }
 
-void UI::DrawMine(int cx, int cy, int size) {
-  if (textureLoaded) {
-    Rectangle source = {0.0f, 0.0f, (float)mineTexture.width,
-                        (float)mineTexture.height};
-    Rectangle dest = {(float)cx, (float)cy, (float)size, (float)size};
-    Vector2 origin = {(float)size / 2.0f, (float)size / 2.0f};
-    DrawTexturePro(mineTexture, source, dest, origin, 0.0f, WHITE);
-  } else {
-    DrawCircle((float)cx, (float)cy, size / 2.5f, BLACK);
-    float spikeLen = size / 2.0f;
-    for (int i = 0; i < 8; i++) {
-      float angle = i * PI / 4.0f;
-      DrawLineEx({(float)cx, (float)cy},
-                 {(float)cx + cos(angle) * spikeLen,
-                  (float)cy + sin(angle) * spikeLen},
-                 2.0f, BLACK);
-    }
-    DrawCircle((float)cx - size / 7.0f, (float)cy - size / 7.0f, size / 10.0f,
-               GRAY);
+bool UI::LoadGridShader() {
+  gridShader = LoadShaderFromMemory(nullptr, gridFragmentShader);
+  gridSizeLoc = GetShaderLocation(gridShader, "gridSize");
+  spriteCountLoc = GetShaderLocation(gridShader, "spriteCount");
+  spritesLoc = GetShaderLocation(gridShader, "sprites");
+  if (gridSizeLoc < 0 || spriteCountLoc < 0 || spritesLoc < 0) {
+    // raylib falls back to its default shader when compilation fails.
+    UnloadShader(gridShader);
+    return false;
   }
+
+  float spriteCount = (float)VISUAL_COUNT;
+  SetShaderValue(gridShader, spriteCountLoc, &spriteCount,
+                 SHADER_UNIFORM_FLOAT);
+
+  stateTexture.id = 0;
+  gridShaderLoaded = true;
+  return true;
 }
 
-void UI::DrawFlag(int cx, int cy, int size) {
-  float baseW = size * 0.7f;
-  float poleH = size * 1.1f;
+void UI::UnloadGridShader() {
+  if (!gridShaderLoaded)
+    return;
+  UnloadShader(gridShader);
+  if (stateTexture.id != 0)
+    UnloadTexture(stateTexture);
+  gridShaderLoaded = false;
+}
 
-  DrawRectangle((int)((float)cx - baseW / 2.0f),
-                (int)((float)cy + poleH / 2.0f - 4.0f), (int)baseW, 4, BLACK);
-  DrawRectangle((int)((float)cx - baseW / 4.0f),
-                (int)((float)cy + poleH / 2.0f - 8.0f), (int)(baseW / 2.0f), 4,
-                BLACK);
+void UI::UpdateStateTexture() {
+  int width = board.GetWidth();
+  int height = board.GetHeight();
+
+  if (stateTexture.id == 0 || stateTexture.width != width ||
+      stateTexture.height != height) {
+    AllocScope scope(ALLOC_RESOURCES);
+    if (stateTexture.id != 0)
+      UnloadTexture(stateTexture);
+    // Texel 0 is VISUAL_HIDDEN; visible tiles are filled in below and the
+    // rest as they scroll into view.
+    std::vector<unsigned char> texels(width * height, VISUAL_HIDDEN);
+    Image image = {texels.data(), width, height, 1,
+                   PIXELFORMAT_UNCOMPRESSED_GRAYSCALE};
+    stateTexture = LoadTextureFromImage(image);
+    SetTextureFilter(stateTexture, TEXTURE_FILTER_POINT);
+    InvalidateTileVersions(stateVersions);
+  }
 
-  DrawRectangle((int)((float)cx - 2.0f), (int)((float)cy - poleH / 2.0f), 4,
-                (int)poleH, BLACK);
+  int x0, y0, x1, y1;
+  GetVisibleCells(x0, y0, x1, y1);
+  int tx0 = x0 / Board::tileSize, ty0 = y0 / Board::tileSize;
+  int tx1 = (x1 + Board::tileSize - 1) / Board::tileSize;
+  int ty1 = (y1 + Board::tileSize - 1) / Board::tileSize;
+
+  unsigned char texels[Board::tileSize * Board::tileSize];
+  for (int ty = ty0; ty < ty1; ty++) {
+    for (int tx = tx0; tx < tx1; tx++) {
+      unsigned int version = board.GetTile(tx, ty).version;
+      unsigned int &uploaded = stateVersions[ty * board.GetTilesX() + tx];
+      if (uploaded == version)
+        continue;
+      uploaded = version;
+
+      int beginX = tx * Board::tileSize;
+      int beginY = ty * Board::tileSize;
+      int tileW = std::min(Board::tileSize, width - beginX);
+      int tileH = std::min(Board::tileSize, height - beginY);
+      for (int y = 0; y < tileH; y++) {
+        for (int x = 0; x < tileW; x++) {
+          texels[y * tileW + x] = GetCellVisual(beginX + x, beginY + y);
+        }
+      }
+      UpdateTextureRec(stateTexture,
+                       {(float)beginX, (float)beginY, (float)tileW,
+                        (float)tileH},
+                       texels);
+    }
+  }
+}
 
-  Vector2 top = {(float)cx, (float)cy - poleH / 2};
-  Vector2 bottom = {(float)cx, (float)cy - poleH / 2 + size * 0.5f};
-  Vector2 tip = {(float)cx - size * 0.5f, (float)cy - poleH / 2 + size * 0.25f};
-  DrawTriangle(bottom, top, tip, RED);
+void UI::DrawBoardShader() {
+  float gridSize[2] = {(float)board.GetWidth(), (float)board.GetHeight()};
+  int x0, y0, x1, y1;
+  GetVisibleCells(x0, y0, x1, y1);
+  float w = (float)(x1 - x0), h = (float)(y1 - y0);
+
+  // Only the visible part of the state texture is drawn; the shader works in
+  // whole-texture coordinates so the sub-rectangle needs no extra uniforms.
+  BeginShaderMode(gridShader);
+  SetShaderValue(gridShader, gridSizeLoc, gridSize, SHADER_UNIFORM_VEC2);
+  SetShaderValueTexture(gridShader, spritesLoc, atlas.GetTexture());
+  DrawTexturePro(stateTexture, {(float)x0, (float)y0, w, h},
+                 {(float)x0 * cellSize, (float)y0 * cellSize, w * cellSize,
+                  h * cellSize},
+                 {0, 0}, 0.0f, WHITE);
+  EndShaderMode();
+}
+
+void UI::InvalidateTileVersions(std::vector<unsigned int> &versions) const {
+  // One behind the board's current version, so every tile reads as changed.
+  versions.resize(board.GetTilesX() * board.GetTilesY());
+  for (int ty = 0; ty < board.GetTilesY(); ty++) {
+    for (int tx = 0; tx < board.GetTilesX(); tx++) {
+      versions[ty * board.GetTilesX() + tx] = board.GetTile(tx, ty).version - 1;
+    }
+  }
 }
 
 void UI::DrawStatsOverlay() {
@@ -280,11 +536,25 @@ void UI::DrawStatsOverlay() {
   DrawRectangleRoundedLines({(float)x, (float)y, (float)w, (float)h}, 0.05f, 8,
                             2.0f, DARKGRAY);
 
+  const StatsKey &config = stats.GetConfig();
+  DrawText(TextFormat("%dx%d, %d mines%s", config.width, config.height,
+                      config.mines, config.noGuess ? ", no-guess" : ""),
+           x + 40, y + h - 25, 15, LIGHTGRAY);
+  DrawText("'S' close, Tab trends",
+           x + (w - MeasureText("'S' close, Tab trends", 15)) / 2, y + h - 25,
+           15, GRAY);
+
+  if (showTrends) {
+    DrawTrends(x, y);
+    return;
+  }
+
   DrawText("STATISTICS", x + 40, y + 25, 25, SKYBLUE);
   DrawLine(x + 300, y + 60, x + 300, y + h - 60,
            DARKGRAY); // Vertical divider
 
-  auto data = stats.GetData();
+  // Everything shown is for the current board configuration only.
+  const ConfigStats &data = stats.GetConfigStats();
   auto getPerc = [&](int val) {
     if (data.gamesStarted == 0)
       return 0.0f;
@@ -295,40 +565,43 @@ void UI::DrawStatsOverlay() {
   if (incomplete < 0)
     incomplete = 0;
 
-  std::stringstream s1, s2, s3, s4;
-  s1 << "Games Played:  " << data.gamesStarted;
-  s2 << "Games Won:     " << data.gamesWon << " (" << std::fixed
-     << std::setprecision(1) << getPerc(data.gamesWon) << "%)";
-  s3 << "Games Lost:    " << data.gamesLost << " (" << std::fixed
-     << std::setprecision(1) << getPerc(data.gamesLost) << "%)";
-  s4 << "Incomplete:    " << incomplete << " (" << std::fixed
-     << std::setprecision(1) << getPerc(incomplete) << "%)";
-
-  std::stringstream f, s, a;
-  f << "Fastest: " << std::fixed << std::setprecision(1)
-    << stats.GetFastestTime() << "s";
-  s << "Slowest: " << std::fixed << std::setprecision(1)
-    << stats.GetSlowestTime() << "s";
-  a << "Average: " << std::fixed << std::setprecision(1)
-    << stats.GetAverageTime() << "s";
-
   int textY = y + 75;
   int textX = x + 40;
-  DrawText(s1.str().c_str(), textX, textY, 18, RAYWHITE);
+  DrawText(TextFormat("Games Played:  %d", data.gamesStarted), textX, textY,
+           18, RAYWHITE);
   textY += 30;
-  DrawText(s2.str().c_str(), textX, textY, 18, GREEN);
+  DrawText(TextFormat("Games Won:     %d (%.1f%%)", data.gamesWon,
+                      getPerc(data.gamesWon)),
+           textX, textY, 18, GREEN);
   textY += 30;
-  DrawText(s3.str().c_str(), textX, textY, 18, RED);
+  DrawText(TextFormat("Games Lost:    %d (%.1f%%)", data.gamesLost,
+                      getPerc(data.gamesLost)),
+           textX, textY, 18, RED);
   textY += 30;
-  DrawText(s4.str().c_str(), textX, textY, 18, ORANGE);
+  DrawText(TextFormat("Incomplete:    %d (%.1f%%)", incomplete,
+                      getPerc(incomplete)),
+           textX, textY, 18, ORANGE);
 
   textY += 60; // Increased gap to 60
   DrawText("TIMING RECORDS", textX, textY - 25, 16, GRAY);
-  DrawText(f.str().c_str(), textX, textY, 18, LIGHTGRAY);
-  textY += 25;
-  DrawText(s.str().c_str(), textX, textY, 18, LIGHTGRAY);
-  textY += 25;
-  DrawText(a.str().c_str(), textX, textY, 18, LIGHTGRAY);
+  DrawText(TextFormat("Fastest: %.1fs", stats.GetFastestTime()), textX, textY,
+           18, LIGHTGRAY);
+  textY += 22;
+  DrawText(TextFormat("Slowest: %.1fs", stats.GetSlowestTime()), textX, textY,
+           18, LIGHTGRAY);
+  textY += 22;
+  DrawText(TextFormat("Average: %.1fs", stats.GetAverageTime()), textX, textY,
+           18, LIGHTGRAY);
+  textY += 22;
+  DrawText(TextFormat("Median:  %.1fs", stats.GetMedianTime()), textX, textY,
+           18, LIGHTGRAY);
+  textY += 22;
+  DrawText(TextFormat("90th %%:  %.1fs", stats.GetP90Time()), textX, textY, 18,
+           LIGHTGRAY);
+  textY += 22;
+  DrawText(TextFormat("Last %d: %.1fs", stats.GetRecentCount(),
+                      stats.GetRecentAverageTime()),
+           textX, textY, 18, LIGHTGRAY);
 
   // Leaderboard Section
   int lbX = x + 330;
@@ -337,24 +610,89 @@ void UI::DrawStatsOverlay() {
 
   const auto &highScores = stats.GetHighScores();
   for (int i = 0; i < 10; i++) {
-    std::string rank = std::to_string(i + 1) + ". ";
-    std::string name = (i < highScores.size()) ? highScores[i].name : "---";
-    std::stringstream ts;
-    if (i < highScores.size())
-      ts << std::fixed << std::setprecision(1) << highScores[i].time << "s";
-    else
-      ts << "---";
-
-    DrawText(rank.c_str(), lbX, lbY + (i * 24), 16, GRAY);
-    DrawText(name.c_str(), lbX + 35, lbY + (i * 24), 16,
-             (i < highScores.size() ? RAYWHITE : DARKGRAY));
-    DrawText(ts.str().c_str(), lbX + 210, lbY + (i * 24), 16,
-             (i < highScores.size() ? SKYBLUE : DARKGRAY));
+    bool filled = i < (int)highScores.size();
+    DrawText(TextFormat("%d. ", i + 1), lbX, lbY + (i * 24), 16, GRAY);
+    DrawText(filled ? highScores[i].name.c_str() : "---", lbX + 35,
+             lbY + (i * 24), 16, (filled ? RAYWHITE : DARKGRAY));
+    DrawText(filled ? TextFormat("%.1fs", highScores[i].time) : "---",
+             lbX + 210, lbY + (i * 24), 16, (filled ? SKYBLUE : DARKGRAY));
   }
+}
 
-  DrawText("Press 'S' to close",
-           x + (w - MeasureText("Press 'S' to close", 15)) / 2, y + h - 25, 15,
-           GRAY);
+void UI::RefreshTrends() {
+  const GameHistory &history = stats.GetHistory();
+  const StatsKey &config = stats.GetConfig();
+  if (trendRows == history.GetRowCount() && trendConfig == config)
+    return;
+  trendRows = history.GetRowCount();
+  trendConfig = config;
+
+  // Buckets span up to 60% of the safe cells, past where 3BV usually lands.
+  int safeCells = config.width * config.height - config.mines;
+  trendBucketSize = std::max(1, safeCells * 6 / 10 / trendBucketCount);
+  history.QueryDays(config, (int64_t)std::time(nullptr), trendDayCount,
+                    trendDays);
+  history.QueryBy3BV(config, trendBucketSize, trendBucketCount,
+                     trendBuckets);
+}
+
+void UI::DrawTrends(int x, int y) {
+  RefreshTrends();
+  DrawText("TRENDS", x + 40, y + 25, 25, SKYBLUE);
+
+  // Win rate per day, today on the right.
+  int games = 0, wins = 0;
+  for (const HistoryDay &day : trendDays) {
+    games += day.games;
+    wins += day.wins;
+  }
+  int chartX = x + 40;
+  int chartW = 570;
+  int chartY = y + 90;
+  int chartH = 100;
+  DrawText("WIN RATE, LAST 30 DAYS", chartX, chartY - 20, 16, GRAY);
+  const char *total = TextFormat("%d games, %.0f%% won", games,
+                                 games > 0 ? wins * 100.0f / games : 0.0f);
+  DrawText(total, chartX + chartW - MeasureText(total, 16), chartY - 20, 16,
+           LIGHTGRAY);
+  int slot = chartW / trendDayCount;
+  for (int i = 0; i < trendDayCount; i++) {
+    const HistoryDay &day = trendDays[trendDayCount - 1 - i];
+    int barX = chartX + i * slot;
+    if (day.games == 0) {
+      DrawRectangle(barX, chartY + chartH - 2, slot - 4, 2, DARKGRAY);
+      continue;
+    }
+    int barH = std::max(2, day.wins * chartH / day.games);
+    DrawRectangle(barX, chartY + chartH - barH, slot - 4, barH,
+                  day.wins > 0 ? GREEN : RED);
+  }
+
+  // Average win time per 3BV bucket, scaled to the slowest bucket.
+  chartY = y + 235;
+  DrawText("AVERAGE WIN TIME BY 3BV", chartX, chartY - 20, 16, GRAY);
+  float slowest = 0.0f;
+  for (const HistoryBucket &b : trendBuckets) {
+    if (b.wins > 0)
+      slowest = std::max(slowest, (float)(b.winTimeSum / b.wins));
+  }
+  slot = chartW / trendBucketCount;
+  for (int i = 0; i < trendBucketCount; i++) {
+    const HistoryBucket &b = trendBuckets[i];
+    int barX = chartX + i * slot;
+    DrawText(TextFormat(i + 1 < trendBucketCount ? "%d" : "%d+",
+                        i * trendBucketSize),
+             barX, chartY + chartH + 4, 10, GRAY);
+    if (b.wins == 0) {
+      DrawRectangle(barX, chartY + chartH - 2, slot - 8, 2, DARKGRAY);
+      continue;
+    }
+    float average = (float)(b.winTimeSum / b.wins);
+    int barH = std::max(2, (int)(average / slowest * (chartH - 14)));
+    DrawRectangle(barX, chartY + chartH - barH, slot - 8, barH, SKYBLUE);
+    DrawText(TextFormat("%.0fs", average), barX, chartY + chartH - barH - 12,
+             10, LIGHTGRAY);
+  }
 }
 
 void UI::DrawNameEntry() {
@@ -369,16 +707,16 @@ void UI::DrawNameEntry() {
   DrawRectangleRoundedLines({(float)x, (float)y, (float)w, (float)h}, 0.1f, 8,
                             2.0f, SKYBLUE);
 
-  std::string title = (currentRank == 1) ? "NEW RECORD!" : "TOP 10 SCORE!";
+  const char *title = (currentRank == 1) ? "NEW RECORD!" : "TOP 10 SCORE!";
   Color titleColor = (currentRank == 1) ? GOLD : YELLOW;
 
-  DrawText(title.c_str(), x + (w - MeasureText(title.c_str(), 25)) / 2, y + 30,
-           25, titleColor);
+  DrawText(title, x + (w - MeasureText(title, 25)) / 2, y + 30, 25,
+           titleColor);
 
-  std::string timeMsg = "Time: " + std::to_string(lastTimeRecord).substr(0, 4) +
-                        "s (Rank #" + std::to_string(currentRank) + ")";
-  DrawText(timeMsg.c_str(), x + (w - MeasureText(timeMsg.c_str(), 20)) / 2,
-           y + 65, 20, RAYWHITE);
+  const char *timeMsg =
+      TextFormat("Time: %.1fs (Rank #%d)", lastTimeRecord, currentRank);
+  DrawText(timeMsg, x + (w - MeasureText(timeMsg, 20)) / 2, y + 65, 20,
+           RAYWHITE);
 
   DrawText("Enter your name:", x + 40, y + 100, 18, LIGHTGRAY);
 
@@ -398,25 +736,3 @@ void UI::DrawNameEntry() {
            GRAY);
 }
 
-Color UI::GetNumberColor(int number) {
-  switch (number) {
-  case 1:
-    return Color{99, 151, 255, 255};
-  case 2:
-    return Color{80, 250, 123, 255};
-  case 3:
-    return Color{255, 85, 85, 255};
-  case 4:
-    return Color{189, 147, 249, 255};
-  case 5:
-    return Color{255, 184, 108, 255};
-  case 6:
-    return Color{139, 233, 253, 255};
-  case 7:
-    return Color{255, 121, 198, 255};
-  case 8:
-    return Color{241, 250, 140, 255};
-  default:
-    return RAYWHITE;
-  }
-}
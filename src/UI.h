@@ -1,30 +1,98 @@
 #include "Board.h"
+#include "CellVisual.h"
+#include "Input.h"
+#include "SpriteAtlas.h"
 #include "StatManager.h"
 #include "raylib.h"
+#include <vector>
 
 class UI {
 public:
-  UI(Board &board, StatManager &stats);
+  UI(Board &board, StatManager &stats, InputSource &input);
   ~UI();
   void Update(float currentTime);
-  void Draw(float currentTime, bool showStats);
+  // `clicks` counts every reveal, flag and chord this game, for the
+  // efficiency shown in the header.
+  void Draw(float currentTime, int clicks, bool showStats);
+  // Brings the atlas and the cached board or state texture up to date. Draw
+  // calls it too, but raylib cannot nest texture modes, so callers drawing
+  // the UI into their own render texture call it first.
+  void Prepare();
 
   // Window controls
   bool IsOverClose(Vector2 mouse) const;
   bool IsOverMinimize(Vector2 mouse) const;
   bool IsOverTitleBar(Vector2 mouse) const;
   bool IsEnteringName() const { return enteringName; }
+  // Switches the stats overlay between totals and history trend charts.
+  void ToggleStatsTrends() {
+    showTrends = !showTrends;
+    trendRows = (size_t)-1;
+  }
+
+  // Draw the board as a single shader quad instead of cached cell sprites.
+  void SetGridShader(bool enabled) { useGridShader = enabled; }
+  bool IsGridShader() const { return useGridShader; }
+
+  // Mouse wheel zooms around the cursor; arrow keys pan when `keyboardPan`.
+  void UpdateCamera(bool keyboardPan);
+  // Maps a screen position through the camera to the cell under it. Returns
+  // false outside the board area or the board itself.
+  bool ScreenToCell(Vector2 screen, int &x, int &y) const;
 
 private:
   Board &board;
   StatManager &stats;
+  InputSource &input;
   Texture2D mineTexture;
   bool textureLoaded = false;
+  SpriteAtlas atlas;
+
+  // Board space is in pixels at zoom 1 with cell (0, 0) at the origin. Only
+  // cells inside the camera's view are refreshed or drawn.
+  Camera2D camera = {};
+  int cameraBoardWidth = 0;
+  int cameraBoardHeight = 0;
+
+  // Board drawn once into a texture; only cells whose visual changed since
+  // the last frame are redrawn, found through the board's tile versions.
+  RenderTexture2D boardTexture;
+  bool boardTextureLoaded = false;
+  std::vector<unsigned char> cellCache;
+  std::vector<unsigned int> tileVersions;
+
+  // Shader grid mode: cell visuals live in a texture with one texel per cell,
+  // re-uploaded per changed tile, and one fragment shader draws every cell
+  // from a strip of baked cell sprites.
+  bool useGridShader = false;
+  bool gridShaderLoaded = false;
+  Shader gridShader;
+  Texture2D stateTexture;
+  std::vector<unsigned int> stateVersions;
+  int spritesLoc = -1;
+  int gridSizeLoc = -1;
+  int spriteCountLoc = -1;
 
   const int cellSize = 32;
   const int titleBarHeight = 35;
   const int statusHeaderHeight = 60;
   const int topBarHeight = 95; // titleBarHeight + statusHeaderHeight
+  const int boardPadding = 20;
+  // Boards larger than this many pixels a side are drawn straight from the
+  // atlas each frame instead of through a cached texture.
+  const int maxCachedBoardSize = 4096;
+  const int maxStateTextureSize = 8192;
+
+  // Trend charts, queried from the game history when a game is added or
+  // the configuration changes rather than every frame.
+  static constexpr int trendDayCount = 30;
+  static constexpr int trendBucketCount = 10;
+  bool showTrends = false;
+  size_t trendRows = (size_t)-1;
+  StatsKey trendConfig;
+  int trendBucketSize = 1;
+  HistoryDay trendDays[trendDayCount];
+  HistoryBucket trendBuckets[trendBucketCount];
 
   // High Score Entry State
   bool enteringName = false;
@@ -38,11 +106,23 @@ private:
   float backspaceInterval = 0.05f; // Rapid repetition
 
   void DrawCustomTitleBar();
-  void DrawStatusHeader(float currentTime);
+  void DrawStatusHeader(float currentTime, int clicks);
   void DrawCell(int x, int y, int offsetX, int offsetY);
+  CellVisual GetCellVisual(int x, int y) const;
+  Rectangle GetBoardArea() const;
+  float GetMinZoom() const;
+  void SyncCamera();
+  void ClampCamera();
+  void GetVisibleCells(int &x0, int &y0, int &x1, int &y1) const;
+  bool UsesBoardTexture() const;
+  void InvalidateTileVersions(std::vector<unsigned int> &versions) const;
+  void UpdateBoardTexture();
+  bool LoadGridShader();
+  void UnloadGridShader();
+  void UpdateStateTexture();
+  void DrawBoardShader();
   void DrawStatsOverlay();
+  void RefreshTrends();
+  void DrawTrends(int x, int y);
   void DrawNameEntry();
-  void DrawMine(int cx, int cy, int size);
-  void DrawFlag(int cx, int cy, int size);
-  Color GetNumberColor(int number);
 };
@@ -1,7 +1,45 @@
 #include "Game.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
-int main() {
-    Game game;
-    game.Run();
-    return 0;
+int main(int argc, char **argv) {
+    GameOptions options;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--board-file") == 0 && i + 1 < argc) {
+            options.boardFile = argv[++i];
+        } else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            options.replayFile = argv[++i];
+        } else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            options.traceFile = argv[++i];
+        } else if (std::strcmp(argv[i], "--record-trace") == 0 &&
+                   i + 1 < argc) {
+            options.recordTraceFile = argv[++i];
+        } else if (std::strcmp(argv[i], "--trace-events") == 0 &&
+                   i + 1 < argc) {
+            TRACE_OUTPUT_FILE(argv[++i]);
+        } else if (std::strcmp(argv[i], "--assert-no-alloc") == 0) {
+            options.assertNoAlloc = true;
+        } else if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            std::sscanf(argv[++i], "%dx%d", &options.boardWidth,
+                        &options.boardHeight);
+        } else if (std::strcmp(argv[i], "--mines") == 0 && i + 1 < argc) {
+            options.boardMines = std::atoi(argv[++i]);
+        }
+    }
+
+    // Leave room for the 3x3 safe area around the first click.
+    options.boardWidth =
+        std::clamp(options.boardWidth, 4, Board::maxSide);
+    options.boardHeight =
+        std::clamp(options.boardHeight, 4, Board::maxSide);
+    options.boardMines = std::max(
+        1, std::min(options.boardMines,
+                    options.boardWidth * options.boardHeight - 9));
+
+    TRACE_THREAD_NAME("main");
+    Game game(options);
+    return game.Run();
 }